@@ -7,6 +7,10 @@
 #define CROSSAUDIO_ENGINE_H
 
 #include "Backend.h"
+#include "Direction.h"
+#include "ErrorCode.h"
+
+#include <stdint.h>
 
 struct CrossAudio_Engine;
 struct CrossAudio_Node;
@@ -16,6 +20,16 @@ struct CrossAudio_EngineFeedback {
 
 	void (*nodeAdded)(void *userData, struct CrossAudio_Node *node);
 	void (*nodeRemoved)(void *userData, struct CrossAudio_Node *node);
+	// A known node changed, e.g. it was renamed.
+	void (*nodeUpdated)(void *userData, struct CrossAudio_Node *node);
+	// The node's direction tells which default changed: input, output or both.
+	void (*defaultNodeChanged)(void *userData, struct CrossAudio_Node *node);
+	// When set, CrossAudio_engineStart() doesn't wait for the engine to be ready: this is called instead,
+	// with the outcome. Only called when CrossAudio_engineStart() succeeded.
+	void (*ready)(void *userData, enum CrossAudio_ErrorCode ec);
+
+	// Milliseconds to wait for a server to accept the connection, 0 waits forever.
+	uint32_t timeout;
 };
 
 #ifdef __cplusplus
@@ -34,6 +48,10 @@ CROSSAUDIO_EXPORT enum CrossAudio_ErrorCode CrossAudio_engineNameSet(struct Cros
 																	 const char *name);
 
 CROSSAUDIO_EXPORT struct CrossAudio_Nodes *CrossAudio_engineNodesGet(struct CrossAudio_Engine *engine);
+// The node used for CROSSAUDIO_DIR_IN or CROSSAUDIO_DIR_OUT fluxes that don't specify one.
+// NULL when unknown or not supported by the backend, otherwise to be freed with CrossAudio_nodeFree().
+CROSSAUDIO_EXPORT struct CrossAudio_Node *CrossAudio_engineDefaultNodeGet(struct CrossAudio_Engine *engine,
+																		  enum CrossAudio_Direction direction);
 
 #ifdef __cplusplus
 }
@@ -16,7 +16,9 @@ enum CrossAudio_ErrorCode {
 	CROSSAUDIO_EC_LIBRARY,
 	CROSSAUDIO_EC_SYMBOL,
 	CROSSAUDIO_EC_CONNECT,
-	CROSSAUDIO_EC_PERMISSION
+	CROSSAUDIO_EC_PERMISSION,
+	CROSSAUDIO_EC_UNSUPPORTED,
+	CROSSAUDIO_EC_TIMEOUT
 };
 
 static inline const char *CrossAudio_ErrorCodeText(const enum CrossAudio_ErrorCode ec) {
@@ -41,6 +43,10 @@ static inline const char *CrossAudio_ErrorCodeText(const enum CrossAudio_ErrorCo
 			return "CROSSAUDIO_EC_CONNECT";
 		case CROSSAUDIO_EC_PERMISSION:
 			return "CROSSAUDIO_EC_PERMISSION";
+		case CROSSAUDIO_EC_UNSUPPORTED:
+			return "CROSSAUDIO_EC_UNSUPPORTED";
+		case CROSSAUDIO_EC_TIMEOUT:
+			return "CROSSAUDIO_EC_TIMEOUT";
 	}
 
 	return "";
@@ -20,6 +20,25 @@
 struct CrossAudio_Engine;
 struct CrossAudio_Flux;
 
+enum CrossAudio_FluxFlag {
+	CROSSAUDIO_FF_NONE = 0,
+	// Size the server's buffers after the requested latency, instead of only the flux's own one.
+	CROSSAUDIO_FF_ADJUST_LATENCY = 1 << 0,
+	// Request data in period sized chunks as early as possible. Mutually exclusive with the flag above.
+	CROSSAUDIO_FF_EARLY_REQUESTS = 1 << 1,
+	// One buffer per channel instead of interleaved frames, see CrossAudio_FluxData.
+	// Backends that cannot provide it fail to start with CROSSAUDIO_EC_UNSUPPORTED.
+	CROSSAUDIO_FF_PLANAR = 1 << 2,
+	// Plug the flux into the graph as one native port per channel, bypassing the server's conversions.
+	// Implies CROSSAUDIO_FF_PLANAR; the sample format and rate are replaced with the graph's.
+	CROSSAUDIO_FF_DSP = 1 << 3,
+	// The flux drives the graph instead of following the device's clock: each cycle is run by CrossAudio_fluxTrigger().
+	CROSSAUDIO_FF_DRIVER = 1 << 4,
+	// The application's clock differs from the device's one, e.g. when bridging network audio: the server resamples
+	// to keep the fill level reported in CrossAudio_FluxData steady. Not compatible with the two flags above.
+	CROSSAUDIO_FF_RATE_MATCH = 1 << 5
+};
+
 struct CrossAudio_FluxConfig {
 	const char *node;
 	enum CrossAudio_Direction direction;
@@ -28,17 +47,58 @@ struct CrossAudio_FluxConfig {
 	uint32_t sampleRate;
 	uint8_t channels;
 	enum CrossAudio_Channel position[CROSSAUDIO_CH_NUM];
+	// Combination of CrossAudio_FluxFlag values.
+	uint32_t flags;
+	// Frames per callback and frames buffered in total, 0 lets the backend decide.
+	// Replaced with the granted values by backends that know them when the flux starts.
+	// The period can change afterwards (e.g. PipeWire's quantum), CrossAudio_FluxTiming.period has the current one.
+	uint32_t period;
+	uint32_t latency;
+	// Fluxes of the same non-zero group are serviced by a dedicated thread with raised priority.
+	// 0 shares the engine's thread. Ignored by backends that only have one.
+	uint32_t group;
+};
+
+struct CrossAudio_FluxTiming {
+	// Frames played/recorded by the device since the flux was started.
+	uint64_t position;
+	// Frames buffered between the application and the device, i.e. the latency.
+	int64_t delay;
+	// Part of the delay still held by the backend/server (queues, resampler), not yet handed to the device.
+	uint64_t buffered;
+	// Monotonic time in nanoseconds at which the values were sampled.
+	int64_t now;
+	// Ratio between the device's clock and the nominal one, as corrected by the server.
+	double rate;
+	// Frames processed by the device/graph in each cycle.
+	uint32_t period;
 };
 
 struct CrossAudio_FluxData {
+	// NULL when capturing silence, e.g. a gap in the recording.
+	// With CROSSAUDIO_FF_PLANAR it's an array of one pointer per channel (void **).
 	void *data;
 	uint32_t frames;
+	// Zeroed when the backend cannot provide it.
+	struct CrossAudio_FluxTiming timing;
+	// With CROSSAUDIO_FF_RATE_MATCH, set by the application: frames held in its own queue
+	// minus the amount it aims for. When positive, a playback device consumes too slowly
+	// and a capture one produces too fast.
+	int32_t fill;
+};
+
+struct CrossAudio_FluxStats {
+	// I/O operations that transferred less than a full block, the remainder being carried over.
+	uint64_t partialTransfers;
 };
 
 struct CrossAudio_FluxFeedback {
 	void *userData;
 
 	void (*process)(void *userData, struct CrossAudio_FluxData *data);
+	// Optional. The flux stopped on its own, e.g. because the device went away; CrossAudio_fluxStop() is still needed.
+	// Only called by backends that can detect it.
+	void (*failed)(void *userData, enum CrossAudio_ErrorCode ec);
 };
 
 #ifdef __cplusplus
@@ -55,6 +115,17 @@ CROSSAUDIO_EXPORT enum CrossAudio_ErrorCode CrossAudio_fluxStart(struct CrossAud
 																 const struct CrossAudio_FluxFeedback *feedback);
 CROSSAUDIO_EXPORT enum CrossAudio_ErrorCode CrossAudio_fluxStop(struct CrossAudio_Flux *flux);
 CROSSAUDIO_EXPORT enum CrossAudio_ErrorCode CrossAudio_fluxPause(struct CrossAudio_Flux *flux, bool on);
+// Switches a running flux to another node, without restarting it.
+CROSSAUDIO_EXPORT enum CrossAudio_ErrorCode CrossAudio_fluxMove(struct CrossAudio_Flux *flux, const char *node);
+// Runs one processing cycle of a flux started with CROSSAUDIO_FF_DRIVER. Can be called from any thread.
+CROSSAUDIO_EXPORT enum CrossAudio_ErrorCode CrossAudio_fluxTrigger(struct CrossAudio_Flux *flux);
+
+// Applied by the library to the samples, ramped over a few milliseconds. Can be called from any thread.
+CROSSAUDIO_EXPORT enum CrossAudio_ErrorCode CrossAudio_fluxVolumeSet(struct CrossAudio_Flux *flux, float volume);
+CROSSAUDIO_EXPORT enum CrossAudio_ErrorCode CrossAudio_fluxMuteSet(struct CrossAudio_Flux *flux, bool on);
+
+CROSSAUDIO_EXPORT enum CrossAudio_ErrorCode CrossAudio_fluxStatsGet(struct CrossAudio_Flux *flux,
+																	struct CrossAudio_FluxStats *stats);
 
 CROSSAUDIO_EXPORT const char *CrossAudio_fluxNameGet(struct CrossAudio_Flux *flux);
 CROSSAUDIO_EXPORT enum CrossAudio_ErrorCode CrossAudio_fluxNameSet(struct CrossAudio_Flux *flux, const char *name);
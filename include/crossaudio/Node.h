@@ -6,16 +6,31 @@
 #ifndef CROSSAUDIO_NODE_H
 #define CROSSAUDIO_NODE_H
 
+#include "BitFormat.h"
 #include "Direction.h"
 #include "ErrorCode.h"
 #include "Macros.h"
 
 #include <stddef.h>
+#include <stdint.h>
+
+struct CrossAudio_NodeFormat {
+	enum CrossAudio_BitFormat bitFormat;
+	uint8_t sampleBits;
+};
 
 struct CrossAudio_Node {
 	char *id;
 	char *name;
 	enum CrossAudio_Direction direction;
+
+	// Capabilities, empty/zero when the backend cannot probe them.
+	size_t formatCount;
+	struct CrossAudio_NodeFormat *formats;
+	size_t rateCount;
+	uint32_t *rates;
+	uint8_t minChannels;
+	uint8_t maxChannels;
 };
 
 struct CrossAudio_Nodes {
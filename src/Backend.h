@@ -17,11 +17,14 @@
 	return &name##_Impl;
 
 typedef enum CrossAudio_Backend Backend;
+typedef enum CrossAudio_Direction Direction;
 typedef enum CrossAudio_ErrorCode ErrorCode;
 
 typedef struct CrossAudio_EngineFeedback EngineFeedback;
 typedef struct CrossAudio_FluxConfig FluxConfig;
 typedef struct CrossAudio_FluxFeedback FluxFeedback;
+typedef struct CrossAudio_FluxStats FluxStats;
+typedef struct CrossAudio_Node Node;
 typedef struct CrossAudio_Nodes Nodes;
 
 typedef struct BE_Engine BE_Engine;
@@ -49,6 +52,15 @@ typedef struct BE_Impl {
 	ErrorCode (*fluxPause)(BE_Flux *flux, bool on);
 	const char *(*fluxNameGet)(BE_Flux *flux);
 	ErrorCode (*fluxNameSet)(BE_Flux *flux, const char *name);
+
+	// Optional, NULL when not supported by the backend.
+	ErrorCode (*fluxStatsGet)(BE_Flux *flux, FluxStats *stats);
+	ErrorCode (*engineStartAsync)(BE_Engine *engine, const EngineFeedback *feedback);
+	ErrorCode (*fluxVolumeSet)(BE_Flux *flux, float volume);
+	ErrorCode (*fluxMuteSet)(BE_Flux *flux, bool on);
+	ErrorCode (*fluxMove)(BE_Flux *flux, const char *node);
+	ErrorCode (*fluxTrigger)(BE_Flux *flux);
+	Node *(*engineDefaultNodeGet)(BE_Engine *engine, Direction direction);
 } BE_Impl;
 
 static inline const BE_Impl *backendGetImpl(const Backend backend) {
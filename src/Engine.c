@@ -9,6 +9,7 @@
 
 #include <stdlib.h>
 
+typedef struct CrossAudio_Node Node;
 typedef struct CrossAudio_Nodes Nodes;
 
 Engine *CrossAudio_engineNew(const Backend backend) {
@@ -40,7 +41,23 @@ ErrorCode CrossAudio_engineFree(Engine *engine) {
 }
 
 ErrorCode CrossAudio_engineStart(Engine *engine, const EngineFeedback *feedback) {
-	return engine->beImpl->engineStart(engine->beData, feedback);
+	const BE_Impl *impl = engine->beImpl;
+
+	if (!feedback || !feedback->ready) {
+		return impl->engineStart(engine->beData, feedback);
+	}
+
+	if (impl->engineStartAsync) {
+		return impl->engineStartAsync(engine->beData, feedback);
+	}
+
+	// The backend is ready as soon as it's started.
+	const ErrorCode ec = impl->engineStart(engine->beData, feedback);
+	if (ec == CROSSAUDIO_EC_OK) {
+		feedback->ready(feedback->userData, ec);
+	}
+
+	return ec;
 }
 
 ErrorCode CrossAudio_engineStop(Engine *engine) {
@@ -58,3 +75,11 @@ ErrorCode CrossAudio_engineNameSet(Engine *engine, const char *name) {
 Nodes *CrossAudio_engineNodesGet(Engine *engine) {
 	return engine->beImpl->engineNodesGet(engine->beData);
 }
+
+Node *CrossAudio_engineDefaultNodeGet(Engine *engine, const Direction direction) {
+	if (!engine->beImpl->engineDefaultNodeGet) {
+		return NULL;
+	}
+
+	return engine->beImpl->engineDefaultNodeGet(engine->beData, direction);
+}
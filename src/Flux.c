@@ -52,6 +52,46 @@ ErrorCode CrossAudio_fluxPause(Flux *flux, const bool on) {
 	return flux->beImpl->fluxPause(flux->beData, on);
 }
 
+ErrorCode CrossAudio_fluxMove(Flux *flux, const char *node) {
+	if (!flux->beImpl->fluxMove) {
+		return CROSSAUDIO_EC_UNSUPPORTED;
+	}
+
+	return flux->beImpl->fluxMove(flux->beData, node);
+}
+
+ErrorCode CrossAudio_fluxTrigger(Flux *flux) {
+	if (!flux->beImpl->fluxTrigger) {
+		return CROSSAUDIO_EC_UNSUPPORTED;
+	}
+
+	return flux->beImpl->fluxTrigger(flux->beData);
+}
+
+ErrorCode CrossAudio_fluxVolumeSet(Flux *flux, const float volume) {
+	if (!flux->beImpl->fluxVolumeSet) {
+		return CROSSAUDIO_EC_UNSUPPORTED;
+	}
+
+	return flux->beImpl->fluxVolumeSet(flux->beData, volume);
+}
+
+ErrorCode CrossAudio_fluxMuteSet(Flux *flux, const bool on) {
+	if (!flux->beImpl->fluxMuteSet) {
+		return CROSSAUDIO_EC_UNSUPPORTED;
+	}
+
+	return flux->beImpl->fluxMuteSet(flux->beData, on);
+}
+
+ErrorCode CrossAudio_fluxStatsGet(Flux *flux, FluxStats *stats) {
+	if (!flux->beImpl->fluxStatsGet) {
+		return CROSSAUDIO_EC_UNSUPPORTED;
+	}
+
+	return flux->beImpl->fluxStatsGet(flux->beData, stats);
+}
+
 const char *CrossAudio_fluxNameGet(Flux *flux) {
 	return flux->beImpl->fluxNameGet(flux->beData);
 }
@@ -12,6 +12,8 @@ typedef enum CrossAudio_ErrorCode ErrorCode;
 static void freeNodeInner(Node *node) {
 	free(node->id);
 	free(node->name);
+	free(node->formats);
+	free(node->rates);
 }
 
 Node *nodeNew(void) {
@@ -29,6 +31,13 @@ Nodes *nodesNew(const size_t count) {
 	return nodes;
 }
 
+void nodeCapsNew(Node *node, const size_t formatCount, const size_t rateCount) {
+	node->formatCount = formatCount;
+	node->formats     = formatCount ? calloc(formatCount, sizeof(NodeFormat)) : NULL;
+	node->rateCount   = rateCount;
+	node->rates       = rateCount ? calloc(rateCount, sizeof(uint32_t)) : NULL;
+}
+
 ErrorCode CrossAudio_nodeFree(Node *node) {
 	freeNodeInner(node);
 
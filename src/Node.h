@@ -9,6 +9,7 @@
 #include "crossaudio/Node.h"
 
 typedef struct CrossAudio_Node Node;
+typedef struct CrossAudio_NodeFormat NodeFormat;
 typedef struct CrossAudio_Nodes Nodes;
 
 #ifdef __cplusplus
@@ -18,6 +19,8 @@ extern "C" {
 Node *nodeNew(void);
 Nodes *nodesNew(size_t count);
 
+void nodeCapsNew(Node *node, size_t formatCount, size_t rateCount);
+
 #ifdef __cplusplus
 }
 #endif
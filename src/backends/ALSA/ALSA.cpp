@@ -130,6 +130,14 @@ const BE_Impl ALSA_Impl = {
 	fluxStop,
 	fluxPause,
 	fluxNameGet,
-	fluxNameSet
+	fluxNameSet,
+
+	nullptr,
+	nullptr,
+	nullptr,
+	nullptr,
+	nullptr,
+	nullptr,
+	nullptr
 };
 // clang-format on
@@ -41,6 +41,10 @@ ErrorCode Flux::start(FluxConfig &config, const FluxFeedback &feedback) {
 		return CROSSAUDIO_EC_INIT;
 	}
 
+	if (config.flags & (CROSSAUDIO_FF_PLANAR | CROSSAUDIO_FF_DSP | CROSSAUDIO_FF_DRIVER | CROSSAUDIO_FF_RATE_MATCH)) {
+		return CROSSAUDIO_EC_UNSUPPORTED;
+	}
+
 	snd_pcm_stream_t dir;
 	std::function< void() > threadFunc;
 
@@ -156,7 +160,7 @@ void Flux::processInput() {
 				}
 			}
 
-			FluxData fluxData = { buffer.data(), static_cast< uint32_t >(ret) };
+			FluxData fluxData = { buffer.data(), static_cast< uint32_t >(ret), {}, 0 };
 			m_feedback.process(m_feedback.userData, &fluxData);
 
 			ret = snd_pcm_avail_update(m_handle);
@@ -182,7 +186,7 @@ void Flux::processOutput() {
 
 		snd_pcm_sframes_t ret = snd_pcm_avail_update(m_handle);
 		while (!m_halt && ret >= m_quantum) {
-			FluxData fluxData = { buffer.data(), m_quantum };
+			FluxData fluxData = { buffer.data(), m_quantum, {}, 0 };
 			m_feedback.process(m_feedback.userData, &fluxData);
 
 			if (!fluxData.frames || !fluxData.data) {
@@ -37,6 +37,10 @@ ErrorCode Flux::start(FluxConfig &config, const FluxFeedback &feedback) {
 		return CROSSAUDIO_EC_INIT;
 	}
 
+	if (config.flags & (CROSSAUDIO_FF_PLANAR | CROSSAUDIO_FF_DSP | CROSSAUDIO_FF_DRIVER | CROSSAUDIO_FF_RATE_MATCH)) {
+		return CROSSAUDIO_EC_UNSUPPORTED;
+	}
+
 	m_halt     = false;
 	m_config   = config;
 	m_feedback = feedback;
@@ -134,7 +138,7 @@ void Flux::processInput() {
 			break;
 		}
 
-		FluxData fluxData = { buffer.data(), static_cast< uint32_t >(bytes / frameSize) };
+		FluxData fluxData = { buffer.data(), static_cast< uint32_t >(bytes / frameSize), {}, 0 };
 		m_feedback.process(m_feedback.userData, &fluxData);
 
 		if (m_pause.test()) {
@@ -151,7 +155,7 @@ void Flux::processOutput() {
 	std::vector< std::byte > buffer(frameSize * DEFAULT_QUANTUM);
 
 	while (!m_halt) {
-		FluxData fluxData = { buffer.data(), DEFAULT_QUANTUM };
+		FluxData fluxData = { buffer.data(), DEFAULT_QUANTUM, {}, 0 };
 		m_feedback.process(m_feedback.userData, &fluxData);
 
 		const auto bytes = write(m_fd.get(), buffer.data(), buffer.size());
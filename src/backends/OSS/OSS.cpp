@@ -148,6 +148,14 @@ const BE_Impl OSS_Impl = {
 	fluxStop,
 	fluxPause,
 	fluxNameGet,
-	fluxNameSet
+	fluxNameSet,
+
+	nullptr,
+	nullptr,
+	nullptr,
+	nullptr,
+	nullptr,
+	nullptr,
+	nullptr
 };
 // clang-format on
@@ -10,10 +10,14 @@
 
 #include "Node.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 
+#include <spa/param/audio/raw.h>
+#include <spa/param/format-utils.h>
+#include <spa/pod/iter.h>
 #include <spa/utils/dict.h>
 
 #include <pipewire/keys.h>
@@ -21,7 +25,15 @@
 
 using namespace pipewire;
 
-Engine::Engine() : m_threadLoop(nullptr), m_context(nullptr), m_core(nullptr) {
+// Listed for nodes that accept a range of rates.
+static constexpr uint32_t standardRates[] = { 8000,  11025,  16000,  22050,  32000,  44100, 48000,
+											  88200, 96000, 176400, 192000, 352800, 384000 };
+
+static void copyNode(::Node &nodeOut, const Engine::Node &nodeIn);
+static constexpr NodeFormat translateFormat(uint32_t format);
+
+Engine::Engine()
+	: m_threadLoop(nullptr), m_context(nullptr), m_core(nullptr), m_snapshot(std::make_shared< const Snapshot >()) {
 	if ((m_threadLoop = lib().thread_loop_new(nullptr, nullptr))) {
 		m_context = lib().context_new(lib().thread_loop_get_loop(m_threadLoop), nullptr, 0);
 	}
@@ -53,10 +65,16 @@ void Engine::unlock() {
 }
 
 ErrorCode Engine::start(const EngineFeedback &feedback) {
-	const EventManager::Feedback eventManagerFeedback{ .nodeAdded = [this](const uint32_t id) { addNode(id); },
-													   .nodeRemoved = [this](const uint32_t id) { removeNode(id); },
-													   .nodeUpdated =
-														   [this](const pw_node_info *info) { updateNode(info); } };
+	const EventManager::Feedback eventManagerFeedback{
+		.nodeAdded = [this](const uint32_t id) { addNode(id); },
+		.nodeRemoved = [this](const uint32_t id) { removeNode(id); },
+		.nodeUpdated = [this](const pw_node_info *info) { updateNode(info); },
+		.nodeFormat =
+			[this](const uint32_t id, const uint32_t index, const spa_pod *format) {
+				updateNodeFormat(id, index, format);
+			},
+		.defaultNodeChanged = [this](const bool in, const char *name) { setDefaultNode(in, name); }
+	};
 
 	if (m_core) {
 		return CROSSAUDIO_EC_INIT;
@@ -82,7 +100,8 @@ ErrorCode Engine::stop() {
 
 	m_eventManager.reset();
 
-	m_nodes.clear();
+	m_pending = std::make_shared< Snapshot >();
+	publish();
 
 	if (m_core) {
 		lib().core_disconnect(m_core);
@@ -121,63 +140,70 @@ ErrorCode Engine::nameSet(const char *name) {
 }
 
 Nodes *Engine::engineNodesGet() {
-	const auto lock = locker();
+	const auto snapshot = loadSnapshot();
 
-	auto nodes = nodesNew(m_nodes.size());
+	auto nodes = nodesNew(snapshot->nodes.size());
 
 	size_t i = 0;
 
-	for (const auto &iter : m_nodes) {
+	for (const auto &iter : snapshot->nodes) {
 		const auto &nodeIn = iter.second;
 		if (!nodeIn.advertised) {
 			continue;
 		}
 
-		auto &nodeOut = nodes->items[i++];
-
-		nodeOut.id        = strdup(nodeIn.id.data());
-		nodeOut.name      = strdup(nodeIn.name.data());
-		nodeOut.direction = nodeIn.direction;
+		copyNode(nodes->items[i++], nodeIn);
 	}
 
 	return nodes;
 }
 
+::Node *Engine::defaultNodeGet(const Direction direction) {
+	const auto snapshot = loadSnapshot();
+
+	const auto &name = direction == CROSSAUDIO_DIR_IN ? snapshot->defaultInName : snapshot->defaultOutName;
+	if ((direction != CROSSAUDIO_DIR_IN && direction != CROSSAUDIO_DIR_OUT) || name.empty()) {
+		return nullptr;
+	}
+
+	return defaultNodeNew(*snapshot, name, direction);
+}
+
+// The handlers below are called by the loop thread. Checks are done on the published snapshot,
+// so that events which don't change anything (the majority) don't copy it.
+
 void Engine::addNode(const uint32_t id) {
-	lock();
-	m_nodes.try_emplace(id, Node());
-	unlock();
+	pending().nodes.try_emplace(id, Node());
+	publish();
 }
 
 void Engine::removeNode(const uint32_t id) {
-	lock();
-	const auto iter = m_nodes.extract(id);
-	unlock();
+	if (!loadSnapshot()->nodes.contains(id)) {
+		return;
+	}
 
-	if (!iter.empty() && m_feedback.nodeRemoved) {
-		const Node &node  = iter.mapped();
-		::Node *nodeNotif = nodeNew();
+	const auto iter = pending().nodes.extract(id);
+	publish();
 
-		nodeNotif->id        = strdup(node.id.data());
-		nodeNotif->name      = strdup(node.name.data());
-		nodeNotif->direction = node.direction;
+	if (m_feedback.nodeRemoved) {
+		::Node *nodeNotif = nodeNew();
+		copyNode(*nodeNotif, iter.mapped());
 
 		m_feedback.nodeRemoved(m_feedback.userData, nodeNotif);
 	}
 }
 
 void Engine::updateNode(const pw_node_info *info) {
-	const auto lock = locker();
+	{
+		const auto snapshot = loadSnapshot();
 
-	const auto iter = m_nodes.find(info->id);
-	if (iter == m_nodes.cend()) {
-		return;
+		const auto iter = snapshot->nodes.find(info->id);
+		if (iter == snapshot->nodes.cend() || iter->second.advertised) {
+			return;
+		}
 	}
 
-	auto &node = iter->second;
-	if (node.advertised) {
-		return;
-	}
+	auto &node = pending().nodes[info->id];
 
 	if (node.id.empty()) {
 		const char *id = spa_dict_lookup(info->props, PW_KEY_NODE_NAME);
@@ -195,6 +221,7 @@ void Engine::updateNode(const pw_node_info *info) {
 
 	if (!(info->n_input_ports || info->n_output_ports) || node.id.empty()) {
 		// Don't advertise the node if it has no ports or ID.
+		publish();
 		return;
 	}
 
@@ -206,17 +233,245 @@ void Engine::updateNode(const pw_node_info *info) {
 		direction |= CROSSAUDIO_DIR_IN;
 	}
 
-	node.direction = static_cast< Direction >(direction);
+	node.direction  = static_cast< Direction >(direction);
+	node.advertised = true;
 
+	::Node *nodeNotif = nullptr;
 	if (m_feedback.nodeAdded) {
-		::Node *nodeNotif = nodeNew();
+		nodeNotif = nodeNew();
+		copyNode(*nodeNotif, node);
+	}
 
-		nodeNotif->id        = strdup(node.id.data());
-		nodeNotif->name      = strdup(node.name.data());
-		nodeNotif->direction = node.direction;
+	// The callback may list the nodes, the new one has to be there.
+	publish();
 
+	if (nodeNotif) {
 		m_feedback.nodeAdded(m_feedback.userData, nodeNotif);
+	}
+}
+
+void Engine::setDefaultNode(const bool in, const char *name) {
+	{
+		const auto snapshot = loadSnapshot();
+		if ((in ? snapshot->defaultInName : snapshot->defaultOutName) == name) {
+			return;
+		}
+	}
+
+	(in ? pending().defaultInName : pending().defaultOutName) = name;
+	publish();
+
+	if (m_feedback.defaultNodeChanged) {
+		m_feedback.defaultNodeChanged(m_feedback.userData, defaultNodeNew(*loadSnapshot(), name,
+																		  in ? CROSSAUDIO_DIR_IN : CROSSAUDIO_DIR_OUT));
+	}
+}
+
+std::shared_ptr< const Engine::Snapshot > Engine::loadSnapshot() const {
+	const std::unique_lock lock(m_snapshotLock);
+	return m_snapshot;
+}
+
+Engine::Snapshot &Engine::pending() {
+	if (!m_pending) {
+		m_pending = std::make_shared< Snapshot >(*loadSnapshot());
+	}
+
+	return *m_pending;
+}
+
+void Engine::publish() {
+	if (m_pending) {
+		const std::unique_lock lock(m_snapshotLock);
+		m_snapshot = std::move(m_pending);
+		m_pending.reset();
+	}
+}
+
+::Node *Engine::defaultNodeNew(const Snapshot &snapshot, const std::string &name, const Direction direction) {
+	::Node *node = nodeNew();
+
+	// The metadata may refer to a node we don't know (yet).
+	for (const auto &iter : snapshot.nodes) {
+		if (iter.second.id == name) {
+			copyNode(*node, iter.second);
+			node->direction = direction;
+			return node;
+		}
+	}
+
+	node->id        = strdup(name.data());
+	node->name      = strdup(name.data());
+	node->direction = direction;
+
+	return node;
+}
+
+void Engine::updateNodeFormat(const uint32_t id, const uint32_t index, const spa_pod *format) {
+	const auto snapshot = loadSnapshot();
+
+	const auto iter = snapshot->nodes.find(id);
+	if (iter == snapshot->nodes.cend()) {
+		return;
+	}
+
+	const Node &current = iter->second;
+	Node node           = current;
+
+	// A new enumeration starts, e.g. after a profile or route change: what we knew may not be valid anymore.
+	if (index == 0) {
+		node.formats.clear();
+		node.rates.clear();
+		node.minChannels = 0;
+		node.maxChannels = 0;
+	}
+
+	uint32_t mediaType, mediaSubtype;
+	if (spa_format_parse(format, &mediaType, &mediaSubtype) >= 0 && mediaType == SPA_MEDIA_TYPE_audio
+		&& mediaSubtype == SPA_MEDIA_SUBTYPE_raw) {
+		parseFormat(node, format);
+	}
+
+	const auto sameFormat = [](const NodeFormat &a, const NodeFormat &b) {
+		return a.bitFormat == b.bitFormat && a.sampleBits == b.sampleBits;
+	};
+
+	if (std::equal(node.formats.cbegin(), node.formats.cend(), current.formats.cbegin(), current.formats.cend(),
+				   sameFormat)
+		&& node.rates == current.rates && node.minChannels == current.minChannels
+		&& node.maxChannels == current.maxChannels) {
+		return;
+	}
+
+	::Node *nodeNotif = nullptr;
+	if (node.advertised && m_feedback.nodeUpdated) {
+		nodeNotif = nodeNew();
+		copyNode(*nodeNotif, node);
+	}
+
+	pending().nodes[id] = std::move(node);
+	publish();
+
+	// The capabilities usually arrive after the node was advertised.
+	if (nodeNotif) {
+		m_feedback.nodeUpdated(m_feedback.userData, nodeNotif);
+	}
+}
+
+void Engine::parseFormat(Node &node, const spa_pod *format) {
+	const auto object = reinterpret_cast< const spa_pod_object * >(format);
+
+	// Each property is either a single value or a choice: for ranges the values are default, min and max.
+	const auto forEachValue = [object](const uint32_t key, const uint32_t type, const auto &func) {
+		const spa_pod_prop *prop = spa_pod_object_find_prop(object, nullptr, key);
+		if (!prop) {
+			return;
+		}
+
+		uint32_t count, choice;
+		const spa_pod *values = spa_pod_get_values(&prop->value, &count, &choice);
+		if (values->type != type) {
+			return;
+		}
+
+		const auto body = static_cast< const uint32_t * >(SPA_POD_BODY(values));
+		if ((choice == SPA_CHOICE_Range || choice == SPA_CHOICE_Step) && count >= 3) {
+			func(body[1], body[2]);
+			return;
+		}
+
+		for (uint32_t i = 0; i < count; ++i) {
+			func(body[i], body[i]);
+		}
+	};
+
+	forEachValue(SPA_FORMAT_AUDIO_format, SPA_TYPE_Id, [&node](const uint32_t value, uint32_t) {
+		const auto format = translateFormat(value);
+		if (format.bitFormat == CROSSAUDIO_BF_NONE) {
+			return;
+		}
+
+		const auto sameFormat = [&format](const NodeFormat &other) {
+			return other.bitFormat == format.bitFormat && other.sampleBits == format.sampleBits;
+		};
+
+		if (std::none_of(node.formats.cbegin(), node.formats.cend(), sameFormat)) {
+			node.formats.push_back(format);
+		}
+	});
+
+	forEachValue(SPA_FORMAT_AUDIO_rate, SPA_TYPE_Int, [&node](const uint32_t min, const uint32_t max) {
+		const auto addRate = [&node](const uint32_t rate) {
+			if (std::find(node.rates.cbegin(), node.rates.cend(), rate) == node.rates.cend()) {
+				node.rates.push_back(rate);
+			}
+		};
+
+		if (min == max) {
+			addRate(min);
+			return;
+		}
+
+		for (const auto rate : standardRates) {
+			if (rate >= min && rate <= max) {
+				addRate(rate);
+			}
+		}
+	});
+
+	std::sort(node.rates.begin(), node.rates.end());
+
+	forEachValue(SPA_FORMAT_AUDIO_channels, SPA_TYPE_Int, [&node](const uint32_t min, const uint32_t max) {
+		const auto minChannels = static_cast< uint8_t >(std::min(min, 255u));
+		const auto maxChannels = static_cast< uint8_t >(std::min(max, 255u));
+
+		node.minChannels = node.maxChannels ? std::min(node.minChannels, minChannels) : minChannels;
+		node.maxChannels = std::max(node.maxChannels, maxChannels);
+	});
+}
+
+static void copyNode(::Node &nodeOut, const Engine::Node &nodeIn) {
+	nodeOut.id          = strdup(nodeIn.id.data());
+	nodeOut.name        = strdup(nodeIn.name.data());
+	nodeOut.direction   = nodeIn.direction;
+	nodeOut.minChannels = nodeIn.minChannels;
+	nodeOut.maxChannels = nodeIn.maxChannels;
+
+	nodeCapsNew(&nodeOut, nodeIn.formats.size(), nodeIn.rates.size());
+	std::copy(nodeIn.formats.cbegin(), nodeIn.formats.cend(), nodeOut.formats);
+	std::copy(nodeIn.rates.cbegin(), nodeIn.rates.cend(), nodeOut.rates);
+}
 
-		node.advertised = true;
+static constexpr NodeFormat translateFormat(const uint32_t format) {
+	switch (format) {
+		case SPA_AUDIO_FORMAT_S8:
+		case SPA_AUDIO_FORMAT_S8P:
+			return { CROSSAUDIO_BF_INTEGER_SIGNED, 8 };
+		case SPA_AUDIO_FORMAT_U8:
+		case SPA_AUDIO_FORMAT_U8P:
+			return { CROSSAUDIO_BF_INTEGER_UNSIGNED, 8 };
+		case SPA_AUDIO_FORMAT_S16:
+		case SPA_AUDIO_FORMAT_S16P:
+			return { CROSSAUDIO_BF_INTEGER_SIGNED, 16 };
+		case SPA_AUDIO_FORMAT_U16:
+			return { CROSSAUDIO_BF_INTEGER_UNSIGNED, 16 };
+		case SPA_AUDIO_FORMAT_S24_32:
+		case SPA_AUDIO_FORMAT_S24_32P:
+			return { CROSSAUDIO_BF_INTEGER_SIGNED, 24 };
+		case SPA_AUDIO_FORMAT_U24_32:
+			return { CROSSAUDIO_BF_INTEGER_UNSIGNED, 24 };
+		case SPA_AUDIO_FORMAT_S32:
+		case SPA_AUDIO_FORMAT_S32P:
+			return { CROSSAUDIO_BF_INTEGER_SIGNED, 32 };
+		case SPA_AUDIO_FORMAT_U32:
+			return { CROSSAUDIO_BF_INTEGER_UNSIGNED, 32 };
+		case SPA_AUDIO_FORMAT_F32:
+		case SPA_AUDIO_FORMAT_F32P:
+			return { CROSSAUDIO_BF_FLOAT, 32 };
+		case SPA_AUDIO_FORMAT_F64:
+		case SPA_AUDIO_FORMAT_F64P:
+			return { CROSSAUDIO_BF_FLOAT, 64 };
+		default:
+			return { CROSSAUDIO_BF_NONE, 0 };
 	}
 }
@@ -14,17 +14,21 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 struct pw_context;
 struct pw_core;
 struct pw_node_info;
 struct pw_thread_loop;
+struct spa_pod;
 
 typedef CrossAudio_Direction Direction;
 typedef CrossAudio_ErrorCode ErrorCode;
 
 typedef CrossAudio_EngineFeedback EngineFeedback;
+typedef CrossAudio_NodeFormat NodeFormat;
 typedef CrossAudio_Nodes Nodes;
 
 namespace pipewire {
@@ -46,6 +50,18 @@ public:
 		std::string name;
 		Direction direction;
 		bool advertised;
+		// From the EnumFormat params.
+		std::vector< NodeFormat > formats;
+		std::vector< uint32_t > rates;
+		uint8_t minChannels;
+		uint8_t maxChannels;
+	};
+
+	// Never modified once published, readers don't have to synchronize with the loop thread.
+	struct Snapshot {
+		std::string defaultInName;
+		std::string defaultOutName;
+		std::map< uint32_t, Node > nodes;
 	};
 
 	Engine();
@@ -62,6 +78,7 @@ public:
 	ErrorCode nameSet(const char *name);
 
 	Nodes *engineNodesGet();
+	CrossAudio_Node *defaultNodeGet(Direction direction);
 
 	ErrorCode start(const EngineFeedback &feedback);
 	ErrorCode stop();
@@ -79,9 +96,23 @@ private:
 	void addNode(uint32_t id);
 	void removeNode(uint32_t id);
 	void updateNode(const pw_node_info *info);
+	void updateNodeFormat(uint32_t id, uint32_t index, const spa_pod *format);
+	void setDefaultNode(bool in, const char *name);
+
+	std::shared_ptr< const Snapshot > loadSnapshot() const;
+	Snapshot &pending();
+	void publish();
+
+	static CrossAudio_Node *defaultNodeNew(const Snapshot &snapshot, const std::string &name, Direction direction);
+	static void parseFormat(Node &node, const spa_pod *format);
 
 	EngineFeedback m_feedback;
-	std::map< uint32_t, Node > m_nodes;
+
+	// Only guards the pointer: readers copy it, they never wait for the handlers.
+	mutable std::mutex m_snapshotLock;
+	std::shared_ptr< const Snapshot > m_snapshot;
+	// Only accessed by the loop thread: the changes of the current event, published once it's handled.
+	std::shared_ptr< Snapshot > m_pending;
 };
 } // namespace pipewire
 
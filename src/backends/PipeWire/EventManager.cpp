@@ -7,42 +7,83 @@
 
 #include "Library.hpp"
 
+#include <string>
+
+#include <spa/param/param.h>
+
 #include <pipewire/core.h>
+#include <pipewire/extensions/metadata.h>
 #include <pipewire/node.h>
 
 using namespace pipewire;
 
-static constexpr auto NODE_TYPE_ID = "PipeWire:Interface:Node";
-
-static constexpr pw_registry_events eventsRegistry = { PW_VERSION_REGISTRY_EVENTS,
-													   [](void *userData, const uint32_t id,
-														  const uint32_t /*permissions*/, const char *type,
-														  const uint32_t /*version*/, const spa_dict * /*props*/) {
-														   if (spa_streq(type, NODE_TYPE_ID)) {
-															   auto &manager = *static_cast< EventManager * >(userData);
-															   manager.addNode(id);
-														   }
-													   },
-													   [](void *userData, const uint32_t id) {
-														   auto &manager = *static_cast< EventManager * >(userData);
-														   manager.removeNode(id);
-													   } };
+static constexpr auto NODE_TYPE_ID     = "PipeWire:Interface:Node";
+static constexpr auto METADATA_TYPE_ID = "PipeWire:Interface:Metadata";
+
+static constexpr auto DEFAULT_SINK_KEY   = "default.audio.sink";
+static constexpr auto DEFAULT_SOURCE_KEY = "default.audio.source";
+
+static std::string parseName(const char *json);
+
+static constexpr pw_registry_events eventsRegistry = {
+	PW_VERSION_REGISTRY_EVENTS,
+	[](void *userData, const uint32_t id, const uint32_t /*permissions*/, const char *type, const uint32_t /*version*/,
+	   const spa_dict *props) {
+		auto &manager = *static_cast< EventManager * >(userData);
+
+		if (spa_streq(type, NODE_TYPE_ID)) {
+			manager.addNode(id);
+		} else if (spa_streq(type, METADATA_TYPE_ID)
+				   && spa_streq(spa_dict_lookup(props, PW_KEY_METADATA_NAME), "default")) {
+			manager.addMetadata(id);
+		}
+	},
+	[](void *userData, const uint32_t id) {
+		auto &manager = *static_cast< EventManager * >(userData);
+		manager.removeGlobal(id);
+	}
+};
 
 static constexpr pw_node_events eventsNode = { PW_VERSION_NODE_EVENTS,
 											   [](void *userData, const pw_node_info *info) {
-												   auto &manager = *static_cast< EventManager * >(userData);
-												   manager.updateNode(info);
+												   auto &node = *static_cast< EventManager::Node * >(userData);
+												   node.manager().updateNode(info);
 											   },
-											   nullptr };
+											   [](void *userData, int /*seq*/, const uint32_t id,
+												  const uint32_t index, const uint32_t /*next*/,
+												  const spa_pod *param) {
+												   auto &node = *static_cast< EventManager::Node * >(userData);
+												   if (id == SPA_PARAM_EnumFormat && param) {
+													   node.manager().updateNodeFormat(node.id(), index, param);
+												   }
+											   } };
+
+static constexpr pw_metadata_events eventsMetadata = {
+	PW_VERSION_METADATA_EVENTS,
+	[](void *userData, const uint32_t subject, const char *key, const char * /*type*/, const char *value) {
+		// The default nodes are global properties, i.e. of the core.
+		if (subject == PW_ID_CORE) {
+			auto &manager = *static_cast< EventManager * >(userData);
+			manager.updateMetadata(key, value);
+		}
+
+		return 0;
+	}
+};
 
 EventManager::EventManager(pw_core *core, const Feedback &feedback)
-	: m_feedback(feedback), m_registry(pw_core_get_registry(core, PW_VERSION_REGISTRY, 0)) {
+	: m_feedback(feedback), m_registry(pw_core_get_registry(core, PW_VERSION_REGISTRY, 0)),
+	  m_metadataId(SPA_ID_INVALID), m_metadata(nullptr) {
 	if (m_registry) {
 		pw_registry_add_listener(m_registry, &m_listener, &eventsRegistry, this);
 	}
 }
 
 EventManager::~EventManager() {
+	if (m_metadata) {
+		removeGlobal(m_metadataId);
+	}
+
 	if (m_registry) {
 		spa_hook_remove(&m_listener);
 		lib().proxy_destroy(reinterpret_cast< pw_proxy * >(m_registry));
@@ -61,15 +102,61 @@ void EventManager::removeNode(const uint32_t id) {
 	}
 }
 
+void EventManager::addMetadata(const uint32_t id) {
+	if (m_metadata) {
+		return;
+	}
+
+	m_metadata = static_cast< pw_proxy * >(pw_registry_bind(m_registry, id, METADATA_TYPE_ID, PW_VERSION_METADATA, 0));
+	if (m_metadata) {
+		m_metadataId = id;
+		lib().proxy_add_object_listener(m_metadata, &m_metadataListener, &eventsMetadata, this);
+	}
+}
+
+void EventManager::removeGlobal(const uint32_t id) {
+	if (id != m_metadataId) {
+		removeNode(id);
+		return;
+	}
+
+	spa_hook_remove(&m_metadataListener);
+	lib().proxy_destroy(m_metadata);
+
+	m_metadataId = SPA_ID_INVALID;
+	m_metadata   = nullptr;
+}
+
+void EventManager::updateMetadata(const char *key, const char *value) {
+	// A NULL key means all properties were removed.
+	const auto name = value ? parseName(value) : std::string();
+
+	if (!key || spa_streq(key, DEFAULT_SOURCE_KEY)) {
+		m_feedback.defaultNodeChanged(true, name.data());
+	}
+	if (!key || spa_streq(key, DEFAULT_SINK_KEY)) {
+		m_feedback.defaultNodeChanged(false, name.data());
+	}
+}
+
 void EventManager::updateNode(const pw_node_info *info) {
 	m_feedback.nodeUpdated(info);
 }
 
+void EventManager::updateNodeFormat(const uint32_t id, const uint32_t index, const spa_pod *format) {
+	m_feedback.nodeFormat(id, index, format);
+}
+
 EventManager::Node::Node(const uint32_t id, EventManager &manager)
-	: m_proxy(static_cast< pw_proxy * >(pw_registry_bind(manager.registry(), id, NODE_TYPE_ID, PW_VERSION_NODE, 0))),
+	: m_id(id), m_manager(manager),
+	  m_proxy(static_cast< pw_proxy * >(pw_registry_bind(manager.registry(), id, NODE_TYPE_ID, PW_VERSION_NODE, 0))),
 	  m_listener() {
 	if (m_proxy) {
-		lib().proxy_add_object_listener(m_proxy, &m_listener, &eventsNode, &manager);
+		lib().proxy_add_object_listener(m_proxy, &m_listener, &eventsNode, this);
+
+		// The server sends the current formats right away, then again whenever they change.
+		uint32_t params[] = { SPA_PARAM_EnumFormat };
+		pw_node_subscribe_params(reinterpret_cast< pw_node * >(m_proxy), params, SPA_N_ELEMENTS(params));
 	}
 }
 
@@ -79,3 +166,23 @@ EventManager::Node::~Node() {
 		lib().proxy_destroy(m_proxy);
 	}
 }
+
+static std::string parseName(const char *json) {
+	// The value is a JSON object, e.g. { "name": "alsa_output.pci-0000_00_1f.3.analog-stereo" }.
+	const char *begin = strstr(json, "\"name\"");
+	if (!begin || !(begin = strchr(begin + 6, ':')) || !(begin = strchr(begin, '"'))) {
+		return {};
+	}
+
+	std::string name;
+
+	for (const char *c = begin + 1; *c && *c != '"'; ++c) {
+		if (*c == '\\' && *(c + 1)) {
+			++c;
+		}
+
+		name += *c;
+	}
+
+	return name;
+}
@@ -16,6 +16,7 @@ struct pw_core;
 struct pw_node_info;
 struct pw_proxy;
 struct pw_registry;
+struct spa_pod;
 
 namespace pipewire {
 class EventManager {
@@ -24,6 +25,10 @@ public:
 		std::function< void(uint32_t id) > nodeAdded;
 		std::function< void(uint32_t id) > nodeRemoved;
 		std::function< void(const pw_node_info *info) > nodeUpdated;
+		// Index of the param in the enumeration, 0 when a new one starts.
+		std::function< void(uint32_t id, uint32_t index, const spa_pod *format) > nodeFormat;
+		// Node name, empty when there is no default anymore.
+		std::function< void(bool in, const char *name) > defaultNodeChanged;
 	};
 
 	class Node {
@@ -31,10 +36,15 @@ public:
 		Node(uint32_t id, EventManager &manager);
 		~Node();
 
+		constexpr auto id() const { return m_id; }
+		constexpr auto &manager() { return m_manager; }
+
 	private:
 		Node(const Node &)            = delete;
 		Node &operator=(const Node &) = delete;
 
+		uint32_t m_id;
+		EventManager &m_manager;
 		pw_proxy *m_proxy;
 		spa_hook m_listener;
 	};
@@ -47,6 +57,11 @@ public:
 	void addNode(uint32_t id);
 	void removeNode(uint32_t id);
 	void updateNode(const pw_node_info *info);
+	void updateNodeFormat(uint32_t id, uint32_t index, const spa_pod *format);
+
+	void addMetadata(uint32_t id);
+	void removeGlobal(uint32_t id);
+	void updateMetadata(const char *key, const char *value);
 
 private:
 	EventManager(const EventManager &)            = delete;
@@ -56,6 +71,11 @@ private:
 	pw_registry *m_registry;
 	spa_hook m_listener;
 	std::unordered_map< uint32_t, Node > m_nodes;
+
+	// The "default" metadata object, holding the default nodes.
+	uint32_t m_metadataId;
+	pw_proxy *m_metadata;
+	spa_hook m_metadataListener;
 };
 } // namespace pipewire
 
@@ -8,10 +8,14 @@
 #include "Engine.hpp"
 #include "Library.hpp"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
 
+#include <spa/node/io.h>
+#include <spa/param/buffers.h>
 #include <spa/param/audio/raw-utils.h>
 #include <spa/pod/builder.h>
 #include <spa/utils/dict.h>
@@ -24,17 +28,42 @@ typedef CrossAudio_FluxData FluxData;
 
 static constexpr spa_audio_info_raw configToInfo(const FluxConfig &config);
 static constexpr spa_audio_format translateFormat(CrossAudio_BitFormat format, uint8_t sampleBits);
+static constexpr spa_audio_format toPlanar(spa_audio_format format);
+static constexpr const char *channelName(CrossAudio_Channel channel);
+
+// Seconds to wait for the server to create the stream's node.
+static constexpr int connectTimeout = 5;
+
+// Gains of the rate matching's PI controller, applied to the fill error in seconds.
+static constexpr double rateMatchKp = 0.05;
+static constexpr double rateMatchKi = 0.005;
+// Largest correction: above any real clock's drift, yet small enough for the pitch change to be inaudible.
+static constexpr double rateMatchMax = 0.002;
+
+// Buffers we ask for: the graph reads/writes one while we process the other.
+static constexpr int32_t bufferCount    = 2;
+static constexpr int32_t bufferCountMax = 16;
+// Frames per buffer: PipeWire's default maximum quantum. The requested period is only a hint, the graph may run
+// at a larger one; pw_buffer.requested tells how much of the buffer is needed in each cycle.
+static constexpr int32_t maxQuantum = 8192;
 
 static constexpr pw_stream_events eventsInput = {
-	PW_VERSION_STREAM_EVENTS, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
-	Flux::processInput,       nullptr, nullptr, nullptr
+	PW_VERSION_STREAM_EVENTS, nullptr, Flux::stateChanged, nullptr, Flux::ioChanged, Flux::paramChanged, nullptr,
+	nullptr,                  Flux::processInput,          nullptr, nullptr,          nullptr
 };
 static constexpr pw_stream_events eventsOutput = {
-	PW_VERSION_STREAM_EVENTS, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
-	Flux::processOutput,      nullptr, nullptr, nullptr
+	PW_VERSION_STREAM_EVENTS, nullptr, Flux::stateChanged, nullptr, Flux::ioChanged, Flux::paramChanged, nullptr,
+	nullptr,                  Flux::processOutput,         nullptr, nullptr,          nullptr
+};
+static constexpr pw_filter_events eventsFilter = {
+	PW_VERSION_FILTER_EVENTS, nullptr, Flux::filterStateChanged, Flux::filterIoChanged, nullptr, nullptr, nullptr,
+	Flux::processFilter,      nullptr, nullptr
 };
 
-Flux::Flux(Engine &engine) : m_engine(engine), m_stream(nullptr), m_frameSize(0) {
+Flux::Flux(Engine &engine)
+	: m_engine(engine), m_stream(nullptr), m_filter(nullptr), m_direction(PW_DIRECTION_INPUT), m_position(nullptr),
+	  m_rateMatch(nullptr), m_rateIntegral(0), m_sampleSize(0), m_frameSize(0), m_sampleRate(0), m_ticksBase(-1),
+	  m_driver(false), m_matchRate(false) {
 	if (engine.m_core) {
 		const auto lock = engine.locker();
 		m_stream        = lib().stream_new(engine.m_core, nullptr, nullptr);
@@ -42,6 +71,10 @@ Flux::Flux(Engine &engine) : m_engine(engine), m_stream(nullptr), m_frameSize(0)
 }
 
 Flux::~Flux() {
+	if (m_filter) {
+		stop();
+	}
+
 	if (m_stream) {
 		const auto lock = m_engine.locker();
 		lib().stream_destroy(m_stream);
@@ -49,10 +82,15 @@ Flux::~Flux() {
 }
 
 ErrorCode Flux::start(FluxConfig &config, const FluxFeedback &feedback) {
-	if (lib().stream_get_state(m_stream, nullptr) != PW_STREAM_STATE_UNCONNECTED) {
+	if (m_filter || lib().stream_get_state(m_stream, nullptr) != PW_STREAM_STATE_UNCONNECTED) {
 		return CROSSAUDIO_EC_INIT;
 	}
 
+	// Filters bypass the server's resampler and a driver has no other clock to follow.
+	if ((config.flags & CROSSAUDIO_FF_RATE_MATCH) && (config.flags & (CROSSAUDIO_FF_DSP | CROSSAUDIO_FF_DRIVER))) {
+		return CROSSAUDIO_EC_UNSUPPORTED;
+	}
+
 	m_feedback = feedback;
 
 	pw_direction direction;
@@ -68,30 +106,92 @@ ErrorCode Flux::start(FluxConfig &config, const FluxFeedback &feedback) {
 			return CROSSAUDIO_EC_GENERIC;
 	}
 
-	m_frameSize = config.sampleBits / 8 * config.channels;
+	m_direction  = direction;
+	m_sampleSize = config.sampleBits / 8;
+	m_frameSize  = m_sampleSize * config.channels;
+	m_sampleRate = config.sampleRate;
+	m_ticksBase  = -1;
+	m_driver     = config.flags & CROSSAUDIO_FF_DRIVER;
+	m_matchRate  = config.flags & CROSSAUDIO_FF_RATE_MATCH;
+
+	m_rateIntegral = 0;
 
 	auto info = configToInfo(config);
 
+	// The graph works with planar samples internally, we can skip the conversion from/to interleaved ones.
+	if (config.flags & CROSSAUDIO_FF_PLANAR) {
+		if ((info.format = toPlanar(info.format)) == SPA_AUDIO_FORMAT_UNKNOWN) {
+			return CROSSAUDIO_EC_UNSUPPORTED;
+		}
+
+		m_planes.resize(config.channels);
+	} else {
+		m_planes.clear();
+	}
+
 	std::byte buffer[1024];
 	spa_pod_builder b     = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
 	const spa_pod *params = spa_format_audio_raw_build(&b, SPA_PARAM_EnumFormat, &info);
 
+	// The graph runs at the quantum of the client asking for the lowest latency,
+	// unless one of them forces it. We only do that when asked to adjust the latency.
+	char latency[32], rate[16], quantum[16];
+	snprintf(latency, sizeof(latency), "%u/%u", config.period, config.sampleRate);
+	snprintf(rate, sizeof(rate), "1/%u", config.sampleRate);
+	snprintf(quantum, sizeof(quantum), "%u", config.period);
+
 	spa_dict_item items[] = { { PW_KEY_MEDIA_TYPE, "Audio" },
 							  { PW_KEY_MEDIA_CATEGORY, direction == PW_DIRECTION_INPUT ? "Capture" : "Playback" },
-							  { PW_KEY_TARGET_OBJECT, config.node } };
-	const spa_dict dict   = SPA_DICT_INIT_ARRAY(items);
+							  { PW_KEY_TARGET_OBJECT, config.node },
+							  { PW_KEY_NODE_LATENCY, latency },
+							  { PW_KEY_NODE_RATE, rate },
+							  { PW_KEY_NODE_FORCE_QUANTUM, quantum } };
+
+	uint32_t nItems = 3;
+	if (config.period && config.sampleRate) {
+		nItems = config.flags & CROSSAUDIO_FF_ADJUST_LATENCY ? 6 : 5;
+	}
+
+	const spa_dict dict = SPA_DICT_INIT(items, nItems);
+
+	if (config.flags & CROSSAUDIO_FF_DSP) {
+		return startFilter(config, direction, dict);
+	}
 
 	uint32_t flags = PW_STREAM_FLAG_MAP_BUFFERS | PW_STREAM_FLAG_RT_PROCESS;
 	if (config.node) {
 		flags |= PW_STREAM_FLAG_AUTOCONNECT;
 	}
+	if (m_driver) {
+		flags |= PW_STREAM_FLAG_DRIVER;
+	}
 
 	const auto lock = m_engine.locker();
 
 	lib().stream_update_properties(m_stream, &dict);
 	lib().stream_add_listener(m_stream, &m_listener, direction == PW_DIRECTION_INPUT ? &eventsInput : &eventsOutput,
 							  this);
-	lib().stream_connect(m_stream, direction, PW_ID_ANY, flags, &params, 1);
+	if (lib().stream_connect(m_stream, direction, PW_ID_ANY, flags, &params, 1) < 0) {
+		spa_hook_remove(&m_listener);
+		return CROSSAUDIO_EC_GENERIC;
+	}
+
+	pw_stream_state state;
+	while ((state = lib().stream_get_state(m_stream, nullptr)) == PW_STREAM_STATE_CONNECTING) {
+		if (lib().thread_loop_timed_wait(m_engine.m_threadLoop, connectTimeout) != 0) {
+			break;
+		}
+	}
+
+	if (state != PW_STREAM_STATE_PAUSED && state != PW_STREAM_STATE_STREAMING) {
+		stop();
+		return state == PW_STREAM_STATE_CONNECTING ? CROSSAUDIO_EC_TIMEOUT : CROSSAUDIO_EC_CONNECT;
+	}
+
+	// Only known if the node was already scheduled, usually it's not: the callbacks' timing reports it afterwards.
+	if (const auto period = currentPeriod()) {
+		config.period = period;
+	}
 
 	return CROSSAUDIO_EC_OK;
 }
@@ -99,8 +199,20 @@ ErrorCode Flux::start(FluxConfig &config, const FluxFeedback &feedback) {
 ErrorCode Flux::stop() {
 	const auto lock = m_engine.locker();
 
-	lib().stream_disconnect(m_stream);
-	spa_hook_remove(&m_listener);
+	if (m_filter) {
+		lib().filter_disconnect(m_filter);
+		spa_hook_remove(&m_listener);
+		lib().filter_destroy(m_filter);
+
+		m_filter = nullptr;
+		m_ports.clear();
+	} else {
+		lib().stream_disconnect(m_stream);
+		spa_hook_remove(&m_listener);
+	}
+
+	m_position  = nullptr;
+	m_rateMatch = nullptr;
 
 	return CROSSAUDIO_EC_OK;
 }
@@ -108,13 +220,30 @@ ErrorCode Flux::stop() {
 ErrorCode Flux::pause(const bool on) {
 	const auto lock = m_engine.locker();
 
-	lib().stream_set_active(m_stream, !on);
+	if (m_filter) {
+		lib().filter_set_active(m_filter, !on);
+	} else {
+		lib().stream_set_active(m_stream, !on);
+	}
 
 	return CROSSAUDIO_EC_OK;
 }
 
+ErrorCode Flux::trigger() {
+	if (!m_driver) {
+		return CROSSAUDIO_EC_INIT;
+	}
+
+	// Safe without the lock: when driving, PipeWire hands the request over to the data thread.
+	const auto ret = m_filter ? lib().filter_trigger_process(m_filter) : lib().stream_trigger_process(m_stream);
+
+	return ret >= 0 ? CROSSAUDIO_EC_OK : CROSSAUDIO_EC_GENERIC;
+}
+
 const char *Flux::nameGet() const {
-	if (const auto props = lib().stream_get_properties(m_stream)) {
+	const auto props =
+		m_filter ? lib().filter_get_properties(m_filter, nullptr) : lib().stream_get_properties(m_stream);
+	if (props) {
 		return lib().properties_get(props, PW_KEY_NODE_NAME);
 	}
 
@@ -127,7 +256,153 @@ ErrorCode Flux::nameSet(const char *name) {
 
 	const auto lock = m_engine.locker();
 
-	return lib().stream_update_properties(m_stream, &dict) >= 1 ? CROSSAUDIO_EC_OK : CROSSAUDIO_EC_GENERIC;
+	const auto ret = m_filter ? lib().filter_update_properties(m_filter, nullptr, &dict)
+							  : lib().stream_update_properties(m_stream, &dict);
+
+	return ret >= 1 ? CROSSAUDIO_EC_OK : CROSSAUDIO_EC_GENERIC;
+}
+
+ErrorCode Flux::startFilter(FluxConfig &config, const pw_direction direction, const spa_dict &dict) {
+	// The ports carry the graph's native samples: mono 32 bit float at its rate.
+	config.bitFormat  = CROSSAUDIO_BF_FLOAT;
+	config.sampleBits = 32;
+	config.flags |= CROSSAUDIO_FF_PLANAR;
+
+	m_planes.resize(config.channels);
+	m_scratch.assign(maxQuantum, 0.f);
+
+	pw_properties *props = lib().properties_new_dict(&dict);
+	if (!props) {
+		return CROSSAUDIO_EC_GENERIC;
+	}
+
+	const auto name = nameGet();
+	if (name) {
+		lib().properties_set(props, PW_KEY_NODE_NAME, name);
+	}
+
+	// Streams are linked by the session manager based on their class.
+	lib().properties_set(props, PW_KEY_MEDIA_CLASS,
+						 direction == PW_DIRECTION_INPUT ? "Stream/Input/Audio" : "Stream/Output/Audio");
+	if (config.node) {
+		lib().properties_set(props, PW_KEY_NODE_AUTOCONNECT, "true");
+	}
+
+	const auto lock = m_engine.locker();
+
+	if (!(m_filter = lib().filter_new(m_engine.m_core, name, props))) {
+		return CROSSAUDIO_EC_GENERIC;
+	}
+
+	lib().filter_add_listener(m_filter, &m_listener, &eventsFilter, this);
+
+	for (uint8_t i = 0; i < config.channels; ++i) {
+		const char *prefix  = direction == PW_DIRECTION_INPUT ? "input" : "output";
+		const char *channel = channelName(config.position[i]);
+
+		char portName[32];
+		if (channel) {
+			snprintf(portName, sizeof(portName), "%s_%s", prefix, channel);
+		} else {
+			snprintf(portName, sizeof(portName), "%s_%u", prefix, i);
+		}
+
+		const spa_dict_item portItems[] = { { PW_KEY_FORMAT_DSP, "32 bit float mono audio" },
+											{ PW_KEY_PORT_NAME, portName },
+											{ PW_KEY_AUDIO_CHANNEL, channel } };
+		const spa_dict portDict         = SPA_DICT_INIT(portItems, channel ? 3u : 2u);
+
+		void *port = lib().filter_add_port(m_filter, direction, PW_FILTER_PORT_FLAG_MAP_BUFFERS, 0,
+										   lib().properties_new_dict(&portDict), nullptr, 0);
+		if (!port) {
+			stop();
+			return CROSSAUDIO_EC_GENERIC;
+		}
+
+		m_ports.push_back(port);
+	}
+
+	const uint32_t flags = PW_FILTER_FLAG_RT_PROCESS | (m_driver ? PW_FILTER_FLAG_DRIVER : 0);
+	if (lib().filter_connect(m_filter, flags, nullptr, 0) < 0) {
+		stop();
+		return CROSSAUDIO_EC_GENERIC;
+	}
+
+	pw_filter_state state;
+	while ((state = lib().filter_get_state(m_filter, nullptr)) == PW_FILTER_STATE_CONNECTING) {
+		if (lib().thread_loop_timed_wait(m_engine.m_threadLoop, connectTimeout) != 0) {
+			break;
+		}
+	}
+
+	if (state != PW_FILTER_STATE_PAUSED && state != PW_FILTER_STATE_STREAMING) {
+		stop();
+		return state == PW_FILTER_STATE_CONNECTING ? CROSSAUDIO_EC_TIMEOUT : CROSSAUDIO_EC_CONNECT;
+	}
+
+	// The ports run at the graph's rate, which is only known once the position area is assigned.
+	while (!m_position || !m_position->clock.rate.denom) {
+		if (lib().thread_loop_timed_wait(m_engine.m_threadLoop, connectTimeout) != 0) {
+			stop();
+			return CROSSAUDIO_EC_TIMEOUT;
+		}
+	}
+
+	config.sampleRate = m_position->clock.rate.denom;
+	config.period     = static_cast< uint32_t >(m_position->clock.duration);
+
+	m_sampleSize = sizeof(float);
+	m_frameSize  = m_sampleSize * config.channels;
+	m_sampleRate = config.sampleRate;
+
+	return CROSSAUDIO_EC_OK;
+}
+
+void Flux::stateChanged(void *userData, pw_stream_state, pw_stream_state, const char *) {
+	auto &flux = *static_cast< Flux * >(userData);
+
+	lib().thread_loop_signal(flux.m_engine.m_threadLoop, false);
+}
+
+void Flux::ioChanged(void *userData, const uint32_t id, void *area, const uint32_t size) {
+	auto &flux = *static_cast< Flux * >(userData);
+
+	switch (id) {
+		case SPA_IO_Position:
+			flux.m_position =
+				area && size >= sizeof(spa_io_position) ? static_cast< spa_io_position * >(area) : nullptr;
+			lib().thread_loop_signal(flux.m_engine.m_threadLoop, false);
+			break;
+		case SPA_IO_RateMatch:
+			// Shared with the server's resampler, only present when the stream's node has one.
+			flux.m_rateMatch =
+				area && size >= sizeof(spa_io_rate_match) ? static_cast< spa_io_rate_match * >(area) : nullptr;
+			break;
+	}
+}
+
+void Flux::paramChanged(void *userData, const uint32_t id, const spa_pod *param) {
+	auto &flux = *static_cast< Flux * >(userData);
+
+	// The format is the one we asked for, what's left is the layout of the buffers carrying it.
+	if (id != SPA_PARAM_Format || !param) {
+		return;
+	}
+
+	const bool planar = !flux.m_planes.empty();
+	const auto blocks = planar ? static_cast< int32_t >(flux.m_planes.size()) : 1;
+	const auto stride = static_cast< int32_t >(planar ? flux.m_sampleSize : flux.m_frameSize);
+
+	std::byte buffer[256];
+	spa_pod_builder b = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
+
+	const spa_pod *params = static_cast< const spa_pod * >(spa_pod_builder_add_object(
+		&b, SPA_TYPE_OBJECT_ParamBuffers, SPA_PARAM_Buffers, SPA_PARAM_BUFFERS_buffers,
+		SPA_POD_CHOICE_RANGE_Int(bufferCount, 1, bufferCountMax), SPA_PARAM_BUFFERS_blocks, SPA_POD_Int(blocks),
+		SPA_PARAM_BUFFERS_size, SPA_POD_CHOICE_RANGE_Int(maxQuantum * stride, stride, INT32_MAX),
+		SPA_PARAM_BUFFERS_stride, SPA_POD_Int(stride)));
+
+	lib().stream_update_params(flux.m_stream, &params, 1);
 }
 
 void Flux::processInput(void *userData) {
@@ -138,15 +413,31 @@ void Flux::processInput(void *userData) {
 		return;
 	}
 
-	spa_data *data = &buf->buffer->datas[0];
-	if (!data->data) {
-		return;
-	}
+	FluxData fluxData;
+
+	if (flux.m_planes.empty()) {
+		spa_data *data = &buf->buffer->datas[0];
+		if (!data->data) {
+			lib().stream_queue_buffer(flux.m_stream, buf);
+			return;
+		}
+
+		fluxData = { data->data, data->chunk->size / data->chunk->stride, flux.timing(), 0 };
+	} else {
+		if (!flux.mapPlanes(buf->buffer, true)) {
+			lib().stream_queue_buffer(flux.m_stream, buf);
+			return;
+		}
 
-	FluxData fluxData = { data->data, data->chunk->size / data->chunk->stride };
+		fluxData = { flux.m_planes.data(), buf->buffer->datas[0].chunk->size / flux.m_sampleSize, flux.timing(), 0 };
+	}
 
 	flux.m_feedback.process(flux.m_feedback.userData, &fluxData);
 
+	if (flux.m_matchRate) {
+		flux.matchRate(fluxData.fill);
+	}
+
 	lib().stream_queue_buffer(flux.m_stream, buf);
 }
 
@@ -158,29 +449,222 @@ void Flux::processOutput(void *userData) {
 		return;
 	}
 
-	spa_data *data = &buf->buffer->datas[0];
-	if (!data->data) {
-		return;
+	spa_buffer *buffer = buf->buffer;
+
+	void *fluxBuffer;
+	uint32_t planes, stride;
+
+	if (flux.m_planes.empty()) {
+		spa_data *data = &buffer->datas[0];
+		if (!data->data) {
+			lib().stream_queue_buffer(flux.m_stream, buf);
+			return;
+		}
+
+		fluxBuffer = data->data;
+		planes     = 1;
+		stride     = flux.m_frameSize;
+	} else {
+		if (!flux.mapPlanes(buffer, false)) {
+			lib().stream_queue_buffer(flux.m_stream, buf);
+			return;
+		}
+
+		fluxBuffer = flux.m_planes.data();
+		planes     = static_cast< uint32_t >(flux.m_planes.size());
+		stride     = flux.m_sampleSize;
+	}
+
+	uint32_t frames = UINT32_MAX;
+	for (uint32_t i = 0; i < planes; ++i) {
+		frames = std::min(frames, buffer->datas[i].maxsize / stride);
+	}
+
+	// What the graph consumes in this cycle, rendering more would only add latency.
+	// Present since 0.3.49, older than the pw_stream_get_time_n() we already depend on.
+	if (buf->requested) {
+		frames = static_cast< uint32_t >(std::min< uint64_t >(frames, buf->requested));
 	}
 
-	FluxData fluxData = { data->data, data->maxsize / flux.m_frameSize };
+	FluxData fluxData = { fluxBuffer, frames, flux.timing(), 0 };
 
 	flux.m_feedback.process(flux.m_feedback.userData, &fluxData);
 
-	if (fluxData.frames) {
-		data->chunk->size = fluxData.frames * flux.m_frameSize;
-	} else {
+	if (flux.m_matchRate) {
+		flux.matchRate(fluxData.fill);
+	}
+
+	if (!fluxData.frames) {
 		// Telling PipeWire that we wrote 0 bytes results in an xrun,
 		// which in turn results in this function being called continuously.
-		memset(data->data, 0, data->maxsize);
-		data->chunk->size = data->maxsize;
+		for (uint32_t i = 0; i < planes; ++i) {
+			memset(buffer->datas[i].data, 0, frames * stride);
+		}
+
+		fluxData.frames = frames;
 	}
 
-	data->chunk->stride = flux.m_frameSize;
+	// Reported back to us as queued frames in pw_time.
+	buf->size = fluxData.frames;
+
+	for (uint32_t i = 0; i < planes; ++i) {
+		spa_data *data = &buffer->datas[i];
+
+		data->chunk->size   = fluxData.frames * stride;
+		data->chunk->offset = 0;
+		data->chunk->stride = stride;
+	}
 
 	lib().stream_queue_buffer(flux.m_stream, buf);
 }
 
+void Flux::filterStateChanged(void *userData, pw_filter_state, pw_filter_state, const char *) {
+	auto &flux = *static_cast< Flux * >(userData);
+
+	lib().thread_loop_signal(flux.m_engine.m_threadLoop, false);
+}
+
+void Flux::filterIoChanged(void *userData, void *portData, const uint32_t id, void *area, const uint32_t size) {
+	// Only the filter's own areas, the ports' ones are handled by PipeWire.
+	if (!portData) {
+		ioChanged(userData, id, area, size);
+	}
+}
+
+void Flux::processFilter(void *userData, spa_io_position *position) {
+	auto &flux = *static_cast< Flux * >(userData);
+
+	const auto frames = static_cast< uint32_t >(position->clock.duration);
+
+	// Ports that are not linked have no buffer, e.g. the rear channels on a stereo device: they get the scratch plane,
+	// silence when capturing and discarded when playing.
+	bool scratch = false;
+	for (size_t i = 0; i < flux.m_ports.size(); ++i) {
+		if (!(flux.m_planes[i] = lib().filter_get_dsp_buffer(flux.m_ports[i], frames))) {
+			flux.m_planes[i] = flux.m_scratch.data();
+			scratch          = true;
+		}
+	}
+
+	if (scratch) {
+		// Only with a quantum above PipeWire's default maximum, we can't allocate here: the cycle is skipped.
+		if (frames > flux.m_scratch.size()) {
+			for (size_t i = 0; i < flux.m_planes.size(); ++i) {
+				if (flux.m_direction == PW_DIRECTION_OUTPUT && flux.m_planes[i] != flux.m_scratch.data()) {
+					memset(flux.m_planes[i], 0, frames * sizeof(float));
+				}
+			}
+
+			return;
+		}
+
+		// The application may have written to it in the previous cycle.
+		if (flux.m_direction == PW_DIRECTION_INPUT) {
+			memset(flux.m_scratch.data(), 0, frames * sizeof(float));
+		}
+	}
+
+	if (flux.m_ticksBase < 0) {
+		flux.m_ticksBase = static_cast< int64_t >(position->clock.position);
+	}
+
+	// All ports belong to our node, which runs at the driver's rate.
+	const FluxTiming timing = { position->clock.position - static_cast< uint64_t >(flux.m_ticksBase),
+								position->clock.delay, 0, static_cast< int64_t >(position->clock.nsec),
+								position->clock.rate_diff, frames };
+
+	FluxData fluxData = { flux.m_planes.data(), frames, timing, 0 };
+
+	flux.m_feedback.process(flux.m_feedback.userData, &fluxData);
+
+	if (flux.m_direction == PW_DIRECTION_OUTPUT && fluxData.frames < frames) {
+		for (const auto plane : flux.m_planes) {
+			memset(static_cast< float * >(plane) + fluxData.frames, 0, (frames - fluxData.frames) * sizeof(float));
+		}
+	}
+}
+
+bool Flux::mapPlanes(const spa_buffer *buffer, const bool input) {
+	if (buffer->n_datas < m_planes.size()) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < m_planes.size(); ++i) {
+		const spa_data &data = buffer->datas[i];
+		if (!data.data) {
+			return false;
+		}
+
+		// Captured samples don't necessarily start at the beginning of the plane.
+		m_planes[i] = static_cast< std::byte * >(data.data) + (input ? data.chunk->offset % data.maxsize : 0);
+	}
+
+	return true;
+}
+
+void Flux::matchRate(const int32_t fill) {
+	if (!m_rateMatch || !m_sampleRate) {
+		return;
+	}
+
+	// In seconds, so that the gains don't depend on the sample rate and quantum.
+	// A full queue asks for a faster device when playing, but for a slower one when capturing.
+	const double error = static_cast< double >(m_direction == PW_DIRECTION_INPUT ? -fill : fill) / m_sampleRate;
+
+	double elapsed = 0;
+	if (m_position && m_position->clock.rate.denom) {
+		const auto &clock = m_position->clock;
+		elapsed           = static_cast< double >(clock.duration) * clock.rate.num / clock.rate.denom;
+	}
+
+	// The integral term absorbs the steady drift, clamped so that it doesn't wind up while saturated.
+	m_rateIntegral = std::clamp(m_rateIntegral + rateMatchKi * error * elapsed, -rateMatchMax, rateMatchMax);
+
+	// Above 1 the server's side runs faster than ours.
+	m_rateMatch->rate = 1.0 + std::clamp(rateMatchKp * error + m_rateIntegral, -rateMatchMax, rateMatchMax);
+	SPA_FLAG_SET(m_rateMatch->flags, SPA_IO_RATE_MATCH_FLAG_ACTIVE);
+}
+
+FluxTiming Flux::timing() {
+	FluxTiming timing = {};
+
+	pw_time time;
+	if (lib().stream_get_time_n(m_stream, &time, sizeof(time)) < 0 || !time.rate.denom) {
+		return timing;
+	}
+
+	// Ticks and delay are expressed in the graph's rate, which is not necessarily ours.
+	const auto toFrames = [&time, this](const int64_t value) {
+		return value * time.rate.num * m_sampleRate / time.rate.denom;
+	};
+
+	const auto ticks = toFrames(static_cast< int64_t >(time.ticks));
+	if (m_ticksBase < 0) {
+		m_ticksBase = ticks;
+	}
+
+	timing.position = static_cast< uint64_t >(ticks - m_ticksBase);
+	timing.buffered = time.queued + time.buffered;
+	timing.delay    = toFrames(time.delay) + static_cast< int64_t >(timing.buffered);
+	timing.now      = time.now;
+
+	if (m_position) {
+		timing.rate   = m_position->clock.rate_diff;
+		timing.period = currentPeriod();
+	}
+
+	return timing;
+}
+
+uint32_t Flux::currentPeriod() const {
+	// The position is shared by all nodes of the graph; its clock holds the current quantum.
+	if (!m_position || !m_position->clock.rate.denom) {
+		return 0;
+	}
+
+	return static_cast< uint32_t >(m_position->clock.duration * m_sampleRate / m_position->clock.rate.denom);
+}
+
 static constexpr spa_audio_info_raw configToInfo(const FluxConfig &config) {
 	spa_audio_info_raw info = {};
 
@@ -239,3 +723,38 @@ static constexpr spa_audio_format translateFormat(const CrossAudio_BitFormat for
 
 	return SPA_AUDIO_FORMAT_UNKNOWN;
 }
+
+static constexpr spa_audio_format toPlanar(const spa_audio_format format) {
+	switch (format) {
+		case SPA_AUDIO_FORMAT_S8:
+			return SPA_AUDIO_FORMAT_S8P;
+		case SPA_AUDIO_FORMAT_U8:
+			return SPA_AUDIO_FORMAT_U8P;
+		case SPA_AUDIO_FORMAT_S16:
+			return SPA_AUDIO_FORMAT_S16P;
+		case SPA_AUDIO_FORMAT_S24_32:
+			return SPA_AUDIO_FORMAT_S24_32P;
+		case SPA_AUDIO_FORMAT_S32:
+			return SPA_AUDIO_FORMAT_S32P;
+		case SPA_AUDIO_FORMAT_F32:
+			return SPA_AUDIO_FORMAT_F32P;
+		case SPA_AUDIO_FORMAT_F64:
+			return SPA_AUDIO_FORMAT_F64P;
+		default:
+			return SPA_AUDIO_FORMAT_UNKNOWN;
+	}
+}
+
+static constexpr const char *channelName(const CrossAudio_Channel channel) {
+	// Same order as CrossAudio_Channel, starting from CROSSAUDIO_CH_MONO.
+	constexpr const char *names[] = { "MONO", "FL",  "FR",  "FC",  "LFE", "SL",  "SR",   "FLC", "FRC",
+									  "RC",   "RL",  "RR",  "TC",  "TFL", "TFC", "TFR",  "TRL", "TRC",
+									  "TRR",  "RLC", "RRC", "FLW", "FRW", "LFE2", "FLH", "FCH", "FRH",
+									  "TFLC", "TFRC", "TSL", "TSR", "LLFE", "RLFE", "BC", "BLC", "BRC" };
+
+	if (channel < CROSSAUDIO_CH_MONO || channel >= CROSSAUDIO_CH_MONO + CROSSAUDIO_ARRAY_SIZE(names)) {
+		return nullptr;
+	}
+
+	return names[channel - CROSSAUDIO_CH_MONO];
+}
@@ -10,15 +10,21 @@
 #include "crossaudio/Flux.h"
 
 #include <cstdint>
+#include <vector>
 
+#include <pipewire/filter.h>
+#include <pipewire/stream.h>
 #include <spa/utils/hook.h>
 
 typedef CrossAudio_ErrorCode ErrorCode;
 
 typedef CrossAudio_FluxConfig FluxConfig;
 typedef CrossAudio_FluxFeedback FluxFeedback;
+typedef CrossAudio_FluxTiming FluxTiming;
 
-struct pw_stream;
+struct spa_buffer;
+struct spa_io_position;
+struct spa_io_rate_match;
 
 namespace pipewire {
 class Engine;
@@ -36,17 +42,46 @@ public:
 	ErrorCode start(FluxConfig &config, const FluxFeedback &feedback);
 	ErrorCode stop();
 	ErrorCode pause(bool on);
+	ErrorCode trigger();
 
 	Engine &m_engine;
 	FluxFeedback m_feedback;
 	spa_hook m_listener;
 	pw_stream *m_stream;
+	pw_filter *m_filter;
+	std::vector< void * > m_ports;
+	pw_direction m_direction;
+	spa_io_position *m_position;
+	spa_io_rate_match *m_rateMatch;
+	double m_rateIntegral;
+	std::vector< void * > m_planes;
+	// Stands in for the buffers of the filter's unlinked ports.
+	std::vector< float > m_scratch;
+	uint32_t m_sampleSize;
 	uint32_t m_frameSize;
-
+	uint32_t m_sampleRate;
+	int64_t m_ticksBase;
+	bool m_driver;
+	bool m_matchRate;
+
+	static void stateChanged(void *userData, pw_stream_state old, pw_stream_state state, const char *error);
+	static void ioChanged(void *userData, uint32_t id, void *area, uint32_t size);
+	static void paramChanged(void *userData, uint32_t id, const spa_pod *param);
 	static void processInput(void *userData);
 	static void processOutput(void *userData);
 
+	static void filterStateChanged(void *userData, pw_filter_state old, pw_filter_state state, const char *error);
+	static void filterIoChanged(void *userData, void *portData, uint32_t id, void *area, uint32_t size);
+	static void processFilter(void *userData, spa_io_position *position);
+
 private:
+	ErrorCode startFilter(FluxConfig &config, pw_direction direction, const spa_dict &dict);
+
+	bool mapPlanes(const spa_buffer *buffer, bool input);
+	void matchRate(int32_t fill);
+	FluxTiming timing();
+	uint32_t currentPeriod() const;
+
 	Flux(const Flux &)            = delete;
 	Flux &operator=(const Flux &) = delete;
 };
@@ -43,7 +43,9 @@ ErrorCode Library::load(const std::string_view libraryName) {
 	LOAD_SYM(core_get_properties)
 	LOAD_SYM(core_update_properties)
 
+	LOAD_SYM(properties_new_dict)
 	LOAD_SYM(properties_get)
+	LOAD_SYM(properties_set)
 
 	LOAD_SYM(proxy_destroy)
 	LOAD_SYM(proxy_add_object_listener)
@@ -57,13 +59,31 @@ ErrorCode Library::load(const std::string_view libraryName) {
 	LOAD_SYM(stream_queue_buffer)
 	LOAD_SYM(stream_get_properties)
 	LOAD_SYM(stream_update_properties)
+	LOAD_SYM(stream_update_params)
 	LOAD_SYM(stream_get_state)
+	LOAD_SYM(stream_trigger_process)
+	LOAD_SYM(stream_get_time_n)
 	LOAD_SYM(stream_add_listener)
 
+	LOAD_SYM(filter_new)
+	LOAD_SYM(filter_destroy)
+	LOAD_SYM(filter_connect)
+	LOAD_SYM(filter_disconnect)
+	LOAD_SYM(filter_add_port)
+	LOAD_SYM(filter_get_dsp_buffer)
+	LOAD_SYM(filter_set_active)
+	LOAD_SYM(filter_get_properties)
+	LOAD_SYM(filter_update_properties)
+	LOAD_SYM(filter_get_state)
+	LOAD_SYM(filter_trigger_process)
+	LOAD_SYM(filter_add_listener)
+
 	LOAD_SYM(thread_loop_new)
 	LOAD_SYM(thread_loop_destroy)
 	LOAD_SYM(thread_loop_lock)
 	LOAD_SYM(thread_loop_unlock)
+	LOAD_SYM(thread_loop_signal)
+	LOAD_SYM(thread_loop_timed_wait)
 	LOAD_SYM(thread_loop_start)
 	LOAD_SYM(thread_loop_stop)
 	LOAD_SYM(thread_loop_get_loop)
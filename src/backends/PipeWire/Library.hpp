@@ -12,6 +12,7 @@
 #include <cstdint>
 #include <string_view>
 
+#include <pipewire/filter.h>
 #include <pipewire/stream.h>
 
 using ErrorCode = CrossAudio_ErrorCode;
@@ -46,7 +47,9 @@ public:
 	const pw_properties *(*core_get_properties)(pw_core *core);
 	int (*core_update_properties)(pw_core *core, const spa_dict *dict);
 
+	pw_properties *(*properties_new_dict)(const spa_dict *dict);
 	const char *(*properties_get)(const pw_properties *properties, const char *key);
+	int (*properties_set)(pw_properties *properties, const char *key, const char *value);
 
 	void (*proxy_destroy)(pw_proxy *proxy);
 	void (*proxy_add_object_listener)(pw_proxy *proxy, spa_hook *listener, const void *funcs, void *data);
@@ -61,13 +64,32 @@ public:
 	int (*stream_queue_buffer)(pw_stream *stream, pw_buffer *buffer);
 	const pw_properties *(*stream_get_properties)(pw_stream *stream);
 	int (*stream_update_properties)(pw_stream *stream, const spa_dict *dict);
+	int (*stream_update_params)(pw_stream *stream, const spa_pod **params, uint32_t n_params);
 	pw_stream_state (*stream_get_state)(pw_stream *stream, const char **error);
+	int (*stream_trigger_process)(pw_stream *stream);
+	int (*stream_get_time_n)(pw_stream *stream, pw_time *time, size_t size);
 	void (*stream_add_listener)(pw_stream *stream, spa_hook *listener, const pw_stream_events *events, void *data);
 
+	pw_filter *(*filter_new)(pw_core *core, const char *name, pw_properties *props);
+	void (*filter_destroy)(pw_filter *filter);
+	int (*filter_connect)(pw_filter *filter, uint32_t flags, const spa_pod **params, uint32_t n_params);
+	int (*filter_disconnect)(pw_filter *filter);
+	void *(*filter_add_port)(pw_filter *filter, uint32_t direction, uint32_t flags, size_t port_data_size,
+							 pw_properties *props, const spa_pod **params, uint32_t n_params);
+	void *(*filter_get_dsp_buffer)(void *port_data, uint32_t n_samples);
+	int (*filter_set_active)(pw_filter *filter, bool active);
+	const pw_properties *(*filter_get_properties)(pw_filter *filter, void *port_data);
+	int (*filter_update_properties)(pw_filter *filter, void *port_data, const spa_dict *dict);
+	pw_filter_state (*filter_get_state)(pw_filter *filter, const char **error);
+	int (*filter_trigger_process)(pw_filter *filter);
+	void (*filter_add_listener)(pw_filter *filter, spa_hook *listener, const pw_filter_events *events, void *data);
+
 	pw_thread_loop *(*thread_loop_new)(const char *name, const spa_dict *props);
 	void (*thread_loop_destroy)(pw_thread_loop *loop);
 	void (*thread_loop_lock)(pw_thread_loop *loop);
 	void (*thread_loop_unlock)(pw_thread_loop *loop);
+	void (*thread_loop_signal)(pw_thread_loop *loop, bool wait_for_accept);
+	int (*thread_loop_timed_wait)(pw_thread_loop *loop, int wait_max_sec);
 	int (*thread_loop_start)(pw_thread_loop *loop);
 	void (*thread_loop_stop)(pw_thread_loop *loop);
 	pw_loop *(*thread_loop_get_loop)(pw_thread_loop *loop);
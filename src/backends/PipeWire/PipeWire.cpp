@@ -103,6 +103,10 @@ static Nodes *engineNodesGet(BE_Engine *engine) {
 	return toImpl(engine)->engineNodesGet();
 }
 
+static ::Node *engineDefaultNodeGet(BE_Engine *engine, const Direction direction) {
+	return toImpl(engine)->defaultNodeGet(direction);
+}
+
 static BE_Flux *fluxNew(BE_Engine *engine) {
 	if (auto flux = new Flux(*toImpl(engine))) {
 		if (*flux) {
@@ -133,6 +137,10 @@ static ErrorCode fluxPause(BE_Flux *flux, const bool on) {
 	return toImpl(flux)->pause(on);
 }
 
+static ErrorCode fluxTrigger(BE_Flux *flux) {
+	return toImpl(flux)->trigger();
+}
+
 static const char *fluxNameGet(BE_Flux *flux) {
 	return toImpl(flux)->nameGet();
 }
@@ -163,6 +171,14 @@ constexpr BE_Impl PipeWire_Impl = {
 	fluxStop,
 	fluxPause,
 	fluxNameGet,
-	fluxNameSet
+	fluxNameSet,
+
+	nullptr,
+	nullptr,
+	nullptr,
+	nullptr,
+	nullptr,
+	fluxTrigger,
+	engineDefaultNodeGet
 };
 // clang-format on
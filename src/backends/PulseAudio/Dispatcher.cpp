@@ -0,0 +1,101 @@
+// Copyright The Mumble Developers. All rights reserved.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Dispatcher.hpp"
+
+#include "Library.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <unistd.h>
+
+#include <sys/resource.h>
+
+using namespace pulseaudio;
+
+Dispatcher::Dispatcher() : m_context(nullptr) {
+	if ((m_threadLoop = lib().threaded_mainloop_new())) {
+		const auto api = lib().threaded_mainloop_get_api(m_threadLoop);
+
+		auto props = lib().proplist_new();
+		lib().proplist_sets(props, PA_PROP_MEDIA_SOFTWARE, "libcrossaudio");
+
+		m_context = lib().context_new_with_proplist(api, nullptr, props);
+
+		lib().proplist_free(props);
+	}
+}
+
+Dispatcher::~Dispatcher() {
+	if (m_context) {
+		lib().threaded_mainloop_lock(m_threadLoop);
+		lib().context_disconnect(m_context);
+		lib().context_unref(m_context);
+		lib().threaded_mainloop_unlock(m_threadLoop);
+	}
+
+	if (m_threadLoop) {
+		lib().threaded_mainloop_stop(m_threadLoop);
+		lib().threaded_mainloop_free(m_threadLoop);
+	}
+}
+
+ErrorCode Dispatcher::start() {
+	lib().context_set_state_callback(m_context, contextState, this);
+
+	if (lib().context_connect(m_context, nullptr, PA_CONTEXT_NOAUTOSPAWN, nullptr) < 0) {
+		return CROSSAUDIO_EC_CONNECT;
+	}
+
+	if (lib().threaded_mainloop_start(m_threadLoop) < 0) {
+		return CROSSAUDIO_EC_GENERIC;
+	}
+
+	m_connectComplete.wait(false);
+
+	lib().threaded_mainloop_lock(m_threadLoop);
+
+	const auto state = lib().context_get_state(m_context);
+	if (state == PA_CONTEXT_READY) {
+		lib().mainloop_api_once(lib().threaded_mainloop_get_api(m_threadLoop), raisePriority, this);
+	}
+
+	lib().threaded_mainloop_unlock(m_threadLoop);
+
+	return state == PA_CONTEXT_READY ? CROSSAUDIO_EC_OK : CROSSAUDIO_EC_CONNECT;
+}
+
+void Dispatcher::contextState(pa_context *context, void *userData) {
+	auto &dispatcher = *static_cast< Dispatcher * >(userData);
+
+	switch (lib().context_get_state(context)) {
+		case PA_CONTEXT_READY:
+		case PA_CONTEXT_FAILED:
+		case PA_CONTEXT_TERMINATED:
+			dispatcher.m_connectComplete.test_and_set();
+			dispatcher.m_connectComplete.notify_all();
+		default:
+			break;
+	}
+}
+
+void Dispatcher::raisePriority(pa_mainloop_api *, void *) {
+	// Called from the mainloop thread. Real-time scheduling requires privileges (or a matching RLIMIT_RTPRIO),
+	// without them we settle for the lowest nice value we're allowed to. Only Linux lets us apply it to this thread
+	// alone, elsewhere it would affect the whole process.
+	sched_param param = {};
+	param.sched_priority = sched_get_priority_min(SCHED_RR);
+
+	if (pthread_setschedparam(pthread_self(), SCHED_RR, &param) != 0) {
+#ifdef __linux__
+		for (int nice = -20; nice < 0; ++nice) {
+			if (setpriority(PRIO_PROCESS, gettid(), nice) == 0) {
+				break;
+			}
+		}
+#endif
+	}
+}
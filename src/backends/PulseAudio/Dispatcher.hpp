@@ -0,0 +1,44 @@
+// Copyright The Mumble Developers. All rights reserved.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef CROSSAUDIO_SRC_BACKENDS_PULSEAUDIO_DISPATCHER_HPP
+#define CROSSAUDIO_SRC_BACKENDS_PULSEAUDIO_DISPATCHER_HPP
+
+#include "crossaudio/ErrorCode.h"
+
+#include <atomic>
+
+struct pa_context;
+struct pa_mainloop_api;
+struct pa_threaded_mainloop;
+
+typedef CrossAudio_ErrorCode ErrorCode;
+
+namespace pulseaudio {
+// Mainloop thread with its own server connection, so that its streams are not delayed by anything else.
+class Dispatcher {
+public:
+	Dispatcher();
+	~Dispatcher();
+
+	constexpr operator bool() const { return m_threadLoop && m_context; }
+
+	ErrorCode start();
+
+	pa_threaded_mainloop *m_threadLoop;
+	pa_context *m_context;
+
+private:
+	Dispatcher(const Dispatcher &)            = delete;
+	Dispatcher &operator=(const Dispatcher &) = delete;
+
+	static void contextState(pa_context *context, void *userData);
+	static void raisePriority(pa_mainloop_api *api, void *userData);
+
+	std::atomic_flag m_connectComplete;
+};
+} // namespace pulseaudio
+
+#endif
@@ -5,6 +5,7 @@
 
 #include "Engine.hpp"
 
+#include "Dispatcher.hpp"
 #include "Library.hpp"
 
 #include "Node.h"
@@ -12,10 +13,15 @@
 #include <cstddef>
 #include <cstring>
 #include <mutex>
+#include <string_view>
+
+#include <sys/time.h>
 
 using namespace pulseaudio;
 
-Engine::Engine() : m_context(nullptr) {
+Engine::Engine()
+	: m_context(nullptr), m_connectResult(CROSSAUDIO_EC_INIT), m_connectTimer(nullptr),
+	  m_snapshot(std::make_shared< const Snapshot >()) {
 	if ((m_threadLoop = lib().threaded_mainloop_new())) {
 		const auto api = lib().threaded_mainloop_get_api(m_threadLoop);
 
@@ -53,7 +59,7 @@ void Engine::unlock() {
 	}
 }
 
-ErrorCode Engine::start(const EngineFeedback &feedback) {
+ErrorCode Engine::start(const EngineFeedback &feedback, const bool async) {
 	switch (lib().context_get_state(m_context)) {
 		case PA_CONTEXT_UNCONNECTED:
 		case PA_CONTEXT_FAILED:
@@ -64,6 +70,7 @@ ErrorCode Engine::start(const EngineFeedback &feedback) {
 	}
 
 	m_feedback = feedback;
+	m_connectComplete.clear();
 
 	lib().context_set_state_callback(m_context, contextState, this);
 	lib().context_set_subscribe_callback(m_context, contextEvent, this);
@@ -72,20 +79,50 @@ ErrorCode Engine::start(const EngineFeedback &feedback) {
 		return CROSSAUDIO_EC_CONNECT;
 	}
 
+	if (feedback.timeout) {
+		timeval time;
+		gettimeofday(&time, nullptr);
+
+		const auto usecs = time.tv_usec + static_cast< int64_t >(feedback.timeout) * 1000;
+		time.tv_sec += usecs / 1000000;
+		time.tv_usec = usecs % 1000000;
+
+		// The mainloop is not running yet, no need to lock it.
+		const auto api = lib().threaded_mainloop_get_api(m_threadLoop);
+		m_connectTimer = api->time_new(api, &time, connectTimeout, this);
+	}
+
 	if (lib().threaded_mainloop_start(m_threadLoop) < 0) {
 		stop();
 		return CROSSAUDIO_EC_GENERIC;
 	}
 
+	if (async) {
+		return CROSSAUDIO_EC_OK;
+	}
+
 	m_connectComplete.wait(false);
 
-	return CROSSAUDIO_EC_OK;
+	return m_connectResult;
 }
 
 ErrorCode Engine::stop() {
 	lock();
 
-	m_nodes.clear();
+	for (const auto &notification : m_notifications) {
+		CrossAudio_nodeFree(notification.node);
+	}
+
+	m_notifications.clear();
+
+	m_pending = std::make_shared< Snapshot >();
+	publish();
+
+	if (m_connectTimer) {
+		const auto api = lib().threaded_mainloop_get_api(m_threadLoop);
+		api->time_free(m_connectTimer);
+		m_connectTimer = nullptr;
+	}
 
 	if (m_context) {
 		lib().context_disconnect(m_context);
@@ -115,13 +152,13 @@ ErrorCode Engine::nameSet(const char *name) {
 }
 
 Nodes *Engine::engineNodesGet() {
-	const std::unique_lock lock(m_nodesLock);
+	const auto snapshot = loadSnapshot();
 
-	auto nodes = nodesNew(m_nodes.size());
+	auto nodes = nodesNew(snapshot->nodes.size());
 
 	size_t i = 0;
 
-	for (const auto &iter : m_nodes) {
+	for (const auto &iter : snapshot->nodes) {
 		const auto &nodeIn = iter.second;
 		auto &nodeOut      = nodes->items[i++];
 
@@ -133,104 +170,249 @@ Nodes *Engine::engineNodesGet() {
 	return nodes;
 }
 
-std::string Engine::defaultInName() {
-	std::unique_lock lock(m_nodesLock);
+::Node *Engine::defaultNodeGet(const Direction direction) {
+	const auto snapshot = loadSnapshot();
+
+	std::string_view name;
+	switch (direction) {
+		case CROSSAUDIO_DIR_IN:
+			name = snapshot->defaultInName;
+			break;
+		case CROSSAUDIO_DIR_OUT:
+			name = snapshot->defaultOutName;
+			break;
+		default:
+			break;
+	}
+
+	if (name.empty()) {
+		return nullptr;
+	}
+
+	std::string_view description = name;
+	for (const auto &iter : snapshot->nodes) {
+		if (iter.second.name == name) {
+			description = iter.second.description;
+			break;
+		}
+	}
+
+	::Node *node = nodeNew();
 
-	return m_defaultInName;
+	node->id        = strndup(name.data(), name.size());
+	node->name      = strndup(description.data(), description.size());
+	node->direction = direction;
+
+	return node;
 }
 
-std::string Engine::defaultOutName() {
-	std::unique_lock lock(m_nodesLock);
+std::string Engine::defaultInName() {
+	return loadSnapshot()->defaultInName;
+}
 
-	return m_defaultOutName;
+std::string Engine::defaultOutName() {
+	return loadSnapshot()->defaultOutName;
 }
 
 void Engine::fixNameIfMonitor(std::string &name) {
-	std::unique_lock lock(m_nodesLock);
+	const auto snapshot = loadSnapshot();
 
-	if (const auto iter = m_nodeMonitors.find(name); iter != m_nodeMonitors.cend()) {
+	if (const auto iter = snapshot->nodeMonitors.find(name); iter != snapshot->nodeMonitors.cend()) {
 		name = iter->second;
 	}
 }
 
-void Engine::addNode(const uint32_t index, const char *name, const char *description, Direction direction,
-					 const char *monitorName) {
-	{
-		std::unique_lock lock(m_nodesLock);
+std::shared_ptr< Dispatcher > Engine::dispatcher(const uint32_t group) {
+	const std::unique_lock lock(m_dispatchersLock);
 
-		if (monitorName) {
-			direction = CROSSAUDIO_DIR_BOTH;
-			m_nodeMonitors.emplace(name, monitorName);
-		}
+	auto &entry = m_dispatchers[group];
+	if (auto dispatcher = entry.lock()) {
+		return dispatcher;
+	}
 
-		m_nodes.emplace(index, Node(name, description, direction));
+	auto dispatcher = std::make_shared< Dispatcher >();
+	if (!*dispatcher || dispatcher->start() != CROSSAUDIO_EC_OK) {
+		return nullptr;
 	}
 
-	if (m_feedback.nodeAdded) {
-		::Node *nodeNotif = nodeNew();
+	entry = dispatcher;
 
-		nodeNotif->id        = strdup(name);
-		nodeNotif->name      = strdup(description);
-		nodeNotif->direction = direction;
+	return dispatcher;
+}
 
-		m_feedback.nodeAdded(m_feedback.userData, nodeNotif);
+void Engine::setNode(const uint32_t index, const char *name, const char *description, Direction direction,
+					 const char *monitorName) {
+	auto &snapshot = pending();
+
+	if (monitorName) {
+		direction = CROSSAUDIO_DIR_BOTH;
 	}
+
+	bool added = false;
+
+	if (const auto iter = snapshot.nodes.find(index); iter == snapshot.nodes.cend()) {
+		snapshot.nodes.emplace(index, Node(name, description, direction));
+		added = true;
+	} else {
+		auto &node = iter->second;
+		if (node.name == name && node.description == description && node.direction == direction) {
+			return;
+		}
+
+		if (node.direction == CROSSAUDIO_DIR_BOTH) {
+			snapshot.nodeMonitors.erase(node.name);
+		}
+
+		node.name        = name;
+		node.description = description;
+		node.direction   = direction;
+	}
+
+	if (monitorName) {
+		snapshot.nodeMonitors.insert_or_assign(name, monitorName);
+	}
+
+	notify(added ? m_feedback.nodeAdded : m_feedback.nodeUpdated, name, description, direction);
 }
 
 void Engine::removeNode(const uint32_t index) {
-	m_nodesLock.lock();
+	auto &snapshot = pending();
 
-	const auto iter = m_nodes.extract(index);
+	const auto iter = snapshot.nodes.extract(index);
 	if (iter.empty()) {
-		m_nodesLock.unlock();
 		return;
 	}
 
 	const Node &node = iter.mapped();
 	if (node.direction == CROSSAUDIO_DIR_BOTH) {
-		m_nodeMonitors.erase(node.name);
+		snapshot.nodeMonitors.erase(node.name);
+	}
+
+	notify(m_feedback.nodeRemoved, node.name.data(), node.description.data(), node.direction);
+}
+
+void Engine::setDefaultNode(const bool in, const char *name) {
+	auto &snapshot = pending();
+	auto &current  = in ? snapshot.defaultInName : snapshot.defaultOutName;
+
+	// Not set when there are no devices.
+	if (!name) {
+		name = "";
+	}
+
+	if (current == name) {
+		return;
+	}
+
+	current = name;
+
+	std::string description = name;
+	for (const auto &iter : snapshot.nodes) {
+		if (iter.second.name == name) {
+			description = iter.second.description;
+			break;
+		}
+	}
+
+	notify(m_feedback.defaultNodeChanged, name, description.data(), in ? CROSSAUDIO_DIR_IN : CROSSAUDIO_DIR_OUT);
+}
+
+std::shared_ptr< const Engine::Snapshot > Engine::loadSnapshot() const {
+	const std::unique_lock lock(m_snapshotLock);
+	return m_snapshot;
+}
+
+Engine::Snapshot &Engine::pending() {
+	if (!m_pending) {
+		m_pending = std::make_shared< Snapshot >(*loadSnapshot());
+	}
+
+	return *m_pending;
+}
+
+void Engine::publish() {
+	if (m_pending) {
+		const std::unique_lock lock(m_snapshotLock);
+		m_snapshot = std::move(m_pending);
+		m_pending.reset();
+	}
+
+	for (const auto &notification : m_notifications) {
+		notification.callback(m_feedback.userData, notification.node);
+	}
+
+	m_notifications.clear();
+}
+
+void Engine::notify(const NodeCallback callback, const char *id, const char *name, const Direction direction) {
+	if (!callback) {
+		return;
 	}
 
-	m_nodesLock.unlock();
+	::Node *node = nodeNew();
 
-	if (m_feedback.nodeRemoved) {
-		::Node *nodeNotif = nodeNew();
+	node->id        = strdup(id);
+	node->name      = strdup(name);
+	node->direction = direction;
 
-		nodeNotif->id        = strdup(node.name.data());
-		nodeNotif->name      = strdup(node.description.data());
-		nodeNotif->direction = node.direction;
+	m_notifications.push_back({ callback, node });
+}
+
+void Engine::connectDone(const ErrorCode ec) {
+	// The context keeps changing state after the first outcome, e.g. when the server goes away.
+	if (m_connectComplete.test()) {
+		return;
+	}
+
+	if (m_connectTimer) {
+		const auto api = lib().threaded_mainloop_get_api(m_threadLoop);
+		api->time_free(m_connectTimer);
+		m_connectTimer = nullptr;
+	}
 
-		m_feedback.nodeRemoved(m_feedback.userData, nodeNotif);
+	m_connectResult = ec;
+
+	m_connectComplete.test_and_set();
+	m_connectComplete.notify_all();
+
+	if (m_feedback.ready) {
+		m_feedback.ready(m_feedback.userData, ec);
 	}
 }
 
 void Engine::serverInfo(pa_context *, const pa_server_info *info, void *userData) {
 	auto &engine = *static_cast< Engine * >(userData);
 
-	std::unique_lock lock(engine.m_nodesLock);
-
-	engine.m_defaultInName  = info->default_source_name;
-	engine.m_defaultOutName = info->default_sink_name;
+	engine.setDefaultNode(true, info->default_source_name);
+	engine.setDefaultNode(false, info->default_sink_name);
+	engine.publish();
 }
 
 void Engine::sinkInfo(pa_context *, const pa_sink_info *info, const int eol, void *userData) {
+	auto &engine = *static_cast< Engine * >(userData);
+
+	// The whole list (or the single info) has been received.
 	if (eol) {
+		engine.publish();
 		return;
 	}
 
-	auto &engine = *static_cast< Engine * >(userData);
-
-	engine.addNode(info->index, info->name, info->description, CROSSAUDIO_DIR_OUT, info->monitor_source_name);
+	engine.setNode(info->index, info->name, info->description, CROSSAUDIO_DIR_OUT, info->monitor_source_name);
 }
 
 void Engine::sourceInfo(pa_context *, const pa_source_info *info, const int eol, void *userData) {
-	if (eol || info->monitor_of_sink != PA_INVALID_INDEX) {
+	auto &engine = *static_cast< Engine * >(userData);
+
+	if (eol) {
+		engine.publish();
 		return;
 	}
 
-	auto &engine = *static_cast< Engine * >(userData);
+	if (info->monitor_of_sink != PA_INVALID_INDEX) {
+		return;
+	}
 
-	engine.addNode(info->index, info->name, info->description, CROSSAUDIO_DIR_IN, nullptr);
+	engine.setNode(info->index, info->name, info->description, CROSSAUDIO_DIR_IN, nullptr);
 }
 
 void Engine::contextEvent(pa_context *context, pa_subscription_event_type_t type, unsigned int index, void *userData) {
@@ -238,15 +420,21 @@ void Engine::contextEvent(pa_context *context, pa_subscription_event_type_t type
 
 	switch (type & PA_SUBSCRIPTION_EVENT_TYPE_MASK) {
 		case PA_SUBSCRIPTION_EVENT_NEW:
+		case PA_SUBSCRIPTION_EVENT_CHANGE:
 			break;
 		case PA_SUBSCRIPTION_EVENT_REMOVE:
 			engine.removeNode(index);
+			engine.publish();
 			[[fallthrough]];
 		default:
 			return;
 	}
 
+	// Sink and source infos are fetched again on change, setNode() only notifies when something we expose differs.
 	switch (type & PA_SUBSCRIPTION_EVENT_FACILITY_MASK) {
+		case PA_SUBSCRIPTION_EVENT_SERVER:
+			lib().operation_unref(lib().context_get_server_info(context, serverInfo, userData));
+			break;
 		case PA_SUBSCRIPTION_EVENT_SINK:
 			lib().operation_unref(lib().context_get_sink_info_by_index(context, index, sinkInfo, userData));
 			break;
@@ -262,26 +450,32 @@ void Engine::contextState(pa_context *context, void *userData) {
 	switch (lib().context_get_state(context)) {
 		case PA_CONTEXT_READY: {
 			const auto mask =
-				static_cast< pa_subscription_mask_t >(PA_SUBSCRIPTION_MASK_SINK | PA_SUBSCRIPTION_MASK_SOURCE);
+				static_cast< pa_subscription_mask_t >(PA_SUBSCRIPTION_MASK_SINK | PA_SUBSCRIPTION_MASK_SOURCE
+													 | PA_SUBSCRIPTION_MASK_SERVER);
 			lib().operation_unref(lib().context_subscribe(context, mask, nullptr, userData));
 
 			lib().operation_unref(lib().context_get_server_info(context, serverInfo, userData));
 			lib().operation_unref(lib().context_get_sink_info_list(context, sinkInfo, userData));
 			lib().operation_unref(lib().context_get_source_info_list(context, sourceInfo, userData));
 
-			[[fallthrough]];
+			engine.connectDone(CROSSAUDIO_EC_OK);
+			break;
 		}
 		case PA_CONTEXT_FAILED:
 		case PA_CONTEXT_TERMINATED:
-			engine.m_connectComplete.test_and_set();
-			engine.m_connectComplete.notify_all();
+			engine.connectDone(CROSSAUDIO_EC_CONNECT);
 		default:
 			break;
 	}
 }
 
-Engine::Node::Node(Node &&node)
-	: name(std::move(node.name)), description(std::move(node.description)), direction(node.direction) {
+void Engine::connectTimeout(pa_mainloop_api *, pa_time_event *, const timeval *, void *userData) {
+	auto &engine = *static_cast< Engine * >(userData);
+
+	engine.connectDone(CROSSAUDIO_EC_TIMEOUT);
+
+	// Gives up on the server, the resulting state change is ignored.
+	lib().context_disconnect(engine.m_context);
 }
 
 Engine::Node::Node(const char *name, const char *description, Direction direction)
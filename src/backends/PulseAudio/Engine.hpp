@@ -14,17 +14,22 @@
 #include <atomic>
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <pulse/def.h>
 
 struct pa_context;
+struct pa_mainloop_api;
 struct pa_server_info;
 struct pa_sink_info;
 struct pa_source_info;
 struct pa_threaded_mainloop;
+struct pa_time_event;
+struct timeval;
 
 typedef CrossAudio_Direction Direction;
 typedef CrossAudio_ErrorCode ErrorCode;
@@ -33,6 +38,8 @@ typedef CrossAudio_EngineFeedback EngineFeedback;
 typedef CrossAudio_Nodes Nodes;
 
 namespace pulseaudio {
+class Dispatcher;
+
 class Engine {
 public:
 	class Locker {
@@ -45,7 +52,6 @@ public:
 	};
 
 	struct Node {
-		Node(Node &&node);
 		Node(const char *name, const char *description, Direction direction);
 
 		std::string name;
@@ -53,6 +59,14 @@ public:
 		Direction direction;
 	};
 
+	// Never modified once published, readers don't have to synchronize with the mainloop.
+	struct Snapshot {
+		std::string defaultInName;
+		std::string defaultOutName;
+		std::map< uint32_t, Node > nodes;
+		std::unordered_map< std::string, std::string > nodeMonitors;
+	};
+
 	Engine();
 	~Engine();
 
@@ -67,23 +81,42 @@ public:
 	ErrorCode nameSet(const char *name);
 
 	Nodes *engineNodesGet();
+	CrossAudio_Node *defaultNodeGet(Direction direction);
 
-	ErrorCode start(const EngineFeedback &feedback);
+	ErrorCode start(const EngineFeedback &feedback, bool async);
 	ErrorCode stop();
 
 	std::string defaultInName();
 	std::string defaultOutName();
 	void fixNameIfMonitor(std::string &name);
 
+	std::shared_ptr< Dispatcher > dispatcher(uint32_t group);
+
+	pa_threaded_mainloop *m_threadLoop;
 	pa_context *m_context;
 
 private:
 	Engine(const Engine &)            = delete;
 	Engine &operator=(const Engine &) = delete;
 
-	void addNode(uint32_t index, const char *name, const char *description, Direction direction,
+	void setNode(uint32_t index, const char *name, const char *description, Direction direction,
 				 const char *monitorName);
 	void removeNode(uint32_t index);
+	void setDefaultNode(bool in, const char *name);
+
+	typedef void (*NodeCallback)(void *userData, CrossAudio_Node *node);
+
+	struct Notification {
+		NodeCallback callback;
+		CrossAudio_Node *node;
+	};
+
+	std::shared_ptr< const Snapshot > loadSnapshot() const;
+	Snapshot &pending();
+	void publish();
+	void notify(NodeCallback callback, const char *id, const char *name, Direction direction);
+
+	void connectDone(ErrorCode ec);
 
 	static void serverInfo(pa_context *context, const pa_server_info *info, void *userData);
 	static void sinkInfo(pa_context *context, const pa_sink_info *info, int eol, void *userData);
@@ -92,18 +125,25 @@ private:
 	static void contextEvent(pa_context *context, pa_subscription_event_type_t type, unsigned int index,
 							 void *userData);
 	static void contextState(pa_context *context, void *userData);
+	static void connectTimeout(pa_mainloop_api *api, pa_time_event *event, const timeval *time, void *userData);
 
 	EngineFeedback m_feedback;
 
 	std::atomic_flag m_connectComplete;
-	pa_threaded_mainloop *m_threadLoop;
+	ErrorCode m_connectResult;
+	pa_time_event *m_connectTimer;
 	std::string m_name;
 
-	std::mutex m_nodesLock;
-	std::string m_defaultInName;
-	std::string m_defaultOutName;
-	std::map< uint32_t, Node > m_nodes;
-	std::unordered_map< std::string, std::string > m_nodeMonitors;
+	std::mutex m_dispatchersLock;
+	std::map< uint32_t, std::weak_ptr< Dispatcher > > m_dispatchers;
+
+	// Only guards the pointer: readers copy it, they never wait for the handlers.
+	mutable std::mutex m_snapshotLock;
+	std::shared_ptr< const Snapshot > m_snapshot;
+	// Only accessed by the mainloop thread: the changes of the current batch, published once it's complete.
+	std::shared_ptr< Snapshot > m_pending;
+	// Sent by publish(), so that the callbacks see the state they announce.
+	std::vector< Notification > m_notifications;
 };
 } // namespace pulseaudio
 
@@ -5,10 +5,12 @@
 
 #include "Flux.hpp"
 
+#include "Dispatcher.hpp"
 #include "Engine.hpp"
 #include "Library.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
@@ -18,11 +20,32 @@ using namespace pulseaudio;
 
 typedef CrossAudio_FluxData FluxData;
 
+static constexpr pa_usec_t USEC_PER_SEC = 1000000;
+
+// How long to wait for the server to move a stream, e.g. in case it goes away in the meantime.
+static constexpr auto moveTimeout = std::chrono::seconds(5);
+
+static constexpr pa_buffer_attr configToAttr(const FluxConfig &config, uint32_t frameSize);
 static constexpr pa_channel_map configToMap(const FluxConfig &config);
+static constexpr pa_stream_flags_t translateFlags(uint32_t flags);
 static constexpr pa_sample_format translateFormat(CrossAudio_BitFormat format, uint8_t sampleBits);
 static constexpr pa_channel_position translateChannel(CrossAudio_Channel channel);
 
-Flux::Flux(Engine &engine) : m_engine(engine), m_stream(nullptr), m_frameSize(0) {
+Flux::Locker::Locker(pa_threaded_mainloop *threadLoop) : m_threadLoop(threadLoop) {
+	if (m_threadLoop) {
+		lib().threaded_mainloop_lock(m_threadLoop);
+	}
+}
+
+Flux::Locker::~Locker() {
+	if (m_threadLoop) {
+		lib().threaded_mainloop_unlock(m_threadLoop);
+	}
+}
+
+Flux::Flux(Engine &engine)
+	: m_engine(engine), m_direction(CROSSAUDIO_DIR_NONE), m_threadLoop(nullptr), m_context(nullptr),
+	  m_stream(nullptr), m_frameSize(0), m_sampleRate(0), m_carrySize(0) {
 }
 
 Flux::~Flux() {
@@ -34,7 +57,18 @@ ErrorCode Flux::start(FluxConfig &config, const FluxFeedback &feedback) {
 		return CROSSAUDIO_EC_INIT;
 	}
 
-	m_feedback = feedback;
+	if (config.flags & (CROSSAUDIO_FF_PLANAR | CROSSAUDIO_FF_DSP | CROSSAUDIO_FF_DRIVER | CROSSAUDIO_FF_RATE_MATCH)) {
+		return CROSSAUDIO_EC_UNSUPPORTED;
+	}
+
+	// The server would only fail to connect the stream.
+	if ((config.flags & CROSSAUDIO_FF_ADJUST_LATENCY) && (config.flags & CROSSAUDIO_FF_EARLY_REQUESTS)) {
+		return CROSSAUDIO_EC_NEGOTIATE;
+	}
+
+	m_feedback  = feedback;
+	m_direction = config.direction;
+	m_connectComplete.clear();
 
 	config.channels = std::min(config.channels, static_cast< uint8_t >(PA_CHANNELS_MAX));
 
@@ -44,84 +78,226 @@ ErrorCode Flux::start(FluxConfig &config, const FluxFeedback &feedback) {
 
 	const pa_channel_map channelMap = configToMap(config);
 
-	m_frameSize = config.sampleBits / 8 * config.channels;
+	m_frameSize  = config.sampleBits / 8 * config.channels;
+	m_sampleRate = config.sampleRate;
+	m_carrySize  = 0;
+
+	m_carry.resize(m_frameSize);
+
+	// The volume reaches its target within 10 ms.
+	if (!m_gain.setup(sampleSpec.format, config.channels, config.sampleRate / 100)) {
+		stop();
+		return CROSSAUDIO_EC_NEGOTIATE;
+	}
+
+	if (config.group) {
+		if (!(m_dispatcher = m_engine.dispatcher(config.group))) {
+			return CROSSAUDIO_EC_CONNECT;
+		}
+
+		m_threadLoop = m_dispatcher->m_threadLoop;
+		m_context    = m_dispatcher->m_context;
+	} else {
+		m_threadLoop = m_engine.m_threadLoop;
+		m_context    = m_engine.m_context;
+	}
+
+	// Keeps the dispatcher alive until we're done with its lock, stop() releases it on failure.
+	const auto dispatcher = m_dispatcher;
+
+	{
+		const auto lock = locker();
+
+		if (m_stream = lib().stream_new(m_context, "", &sampleSpec, &channelMap); !m_stream) {
+			return CROSSAUDIO_EC_GENERIC;
+		}
+
+		lib().stream_set_state_callback(m_stream, streamState, this);
+
+		std::string nodeID;
+		if (config.node && strcmp(config.node, CROSSAUDIO_FLUX_DEFAULT_NODE) != 0) {
+			nodeID = config.node;
+		}
 
-	if (m_stream = lib().stream_new(m_engine.m_context, "", &sampleSpec, &channelMap); !m_stream) {
-		return CROSSAUDIO_EC_GENERIC;
+		const auto bufferAttr = configToAttr(config, m_frameSize);
+
+		// Replaced once the server granted the attributes.
+		m_silence.assign(bufferAttr.minreq, std::byte(0));
+
+		// The timing info is kept up to date by the server, and interpolated in between the updates.
+		const auto flags = static_cast< pa_stream_flags_t >(translateFlags(config.flags) | PA_STREAM_AUTO_TIMING_UPDATE
+															| PA_STREAM_INTERPOLATE_TIMING);
+
+		int ret;
+		switch (config.direction) {
+			case CROSSAUDIO_DIR_IN:
+				if (nodeID.empty()) {
+					nodeID = m_engine.defaultInName();
+				} else {
+					m_engine.fixNameIfMonitor(nodeID);
+				}
+
+				lib().stream_set_read_callback(
+					m_stream,
+					[](pa_stream *, size_t bytes, void *userData) {
+						static_cast< Flux * >(userData)->processInput(bytes);
+					},
+					this);
+
+				ret = lib().stream_connect_record(m_stream, nodeID.data(), &bufferAttr, flags);
+				break;
+			case CROSSAUDIO_DIR_OUT: {
+				if (nodeID.empty()) {
+					nodeID = m_engine.defaultOutName();
+				}
+
+				lib().stream_set_write_callback(
+					m_stream,
+					[](pa_stream *, size_t bytes, void *userData) {
+						static_cast< Flux * >(userData)->processOutput(bytes);
+					},
+					this);
+
+				ret = lib().stream_connect_playback(m_stream, nodeID.data(), &bufferAttr, flags, nullptr, nullptr);
+				break;
+			}
+			default:
+				ret = -1;
+		}
+
+		if (ret < 0) {
+			stop();
+			return CROSSAUDIO_EC_GENERIC;
+		}
 	}
 
+	// The server decides the actual buffer attributes, they are only known once the stream is ready.
+	m_connectComplete.wait(false);
+
+	const auto lock = locker();
+
+	if (lib().stream_get_state(m_stream) != PA_STREAM_READY) {
+		stop();
+		return CROSSAUDIO_EC_CONNECT;
+	}
+
+	if (const auto bufferAttr = lib().stream_get_buffer_attr(m_stream)) {
+		if (config.direction == CROSSAUDIO_DIR_IN) {
+			config.period  = bufferAttr->fragsize / m_frameSize;
+			config.latency = bufferAttr->fragsize / m_frameSize;
+		} else {
+			config.period  = bufferAttr->minreq / m_frameSize;
+			config.latency = bufferAttr->tlength / m_frameSize;
+		}
+	}
+
+	return CROSSAUDIO_EC_OK;
+}
+
+ErrorCode Flux::stop() {
+	{
+		const auto lock = locker();
+
+		if (m_stream) {
+			lib().stream_set_state_callback(m_stream, nullptr, nullptr);
+			lib().stream_disconnect(m_stream);
+			lib().stream_unref(m_stream);
+			m_stream = nullptr;
+		}
+	}
+
+	// The dispatcher's thread is stopped when its last flux is.
+	m_dispatcher.reset();
+
+	return CROSSAUDIO_EC_OK;
+}
+
+ErrorCode Flux::pause(const bool on) {
+	const auto lock = locker();
+
+	lib().operation_unref(lib().stream_cork(m_stream, on, nullptr, nullptr));
+
+	return CROSSAUDIO_EC_OK;
+}
+
+ErrorCode Flux::move(const char *node) {
 	std::string nodeID;
-	if (config.node && strcmp(config.node, CROSSAUDIO_FLUX_DEFAULT_NODE) != 0) {
-		nodeID = config.node;
+	if (node && strcmp(node, CROSSAUDIO_FLUX_DEFAULT_NODE) != 0) {
+		nodeID = node;
 	}
 
-	pa_buffer_attr bufferAttr;
-	const uint32_t bytes = m_frameSize * config.sampleRate / 100;
-	bufferAttr.tlength   = bytes;
-	bufferAttr.minreq    = bytes;
-	bufferAttr.maxlength = static_cast< decltype(bufferAttr.maxlength) >(-1);
-	bufferAttr.prebuf    = static_cast< decltype(bufferAttr.prebuf) >(-1);
-	bufferAttr.fragsize  = bytes;
-
-	int ret;
-	switch (config.direction) {
-		case CROSSAUDIO_DIR_IN:
+	pa_operation *operation;
+
+	{
+		const auto lock = locker();
+
+		if (!m_stream || lib().stream_get_state(m_stream) != PA_STREAM_READY) {
+			return CROSSAUDIO_EC_INIT;
+		}
+
+		m_moveResult.reset();
+
+		const uint32_t index = lib().stream_get_index(m_stream);
+
+		if (m_direction == CROSSAUDIO_DIR_IN) {
 			if (nodeID.empty()) {
 				nodeID = m_engine.defaultInName();
 			} else {
 				m_engine.fixNameIfMonitor(nodeID);
 			}
 
-			lib().stream_set_read_callback(
-				m_stream,
-				[](pa_stream *, size_t bytes, void *userData) { static_cast< Flux * >(userData)->processInput(bytes); },
-				this);
-
-			ret = lib().stream_connect_record(m_stream, nodeID.data(), &bufferAttr, PA_STREAM_NOFLAGS);
-			break;
-		case CROSSAUDIO_DIR_OUT: {
+			operation =
+				lib().context_move_source_output_by_index(m_context, index, nodeID.data(), moveComplete, this);
+		} else {
 			if (nodeID.empty()) {
 				nodeID = m_engine.defaultOutName();
 			}
 
-			lib().stream_set_write_callback(
-				m_stream,
-				[](pa_stream *, size_t bytes, void *userData) {
-					static_cast< Flux * >(userData)->processOutput(bytes);
-				},
-				this);
+			operation = lib().context_move_sink_input_by_index(m_context, index, nodeID.data(), moveComplete, this);
+		}
 
-			ret = lib().stream_connect_playback(m_stream, nodeID.data(), &bufferAttr, PA_STREAM_NOFLAGS, nullptr,
-												nullptr);
-			break;
+		if (!operation) {
+			return CROSSAUDIO_EC_GENERIC;
 		}
-		default:
-			ret = -1;
 	}
 
-	if (ret < 0) {
-		stop();
-		return CROSSAUDIO_EC_GENERIC;
+	// The stream keeps running while the server moves it, we only wait for the outcome.
+	{
+		std::unique_lock moveLock(m_moveLock);
+		m_moveCond.wait_for(moveLock, moveTimeout, [this]() { return m_moveResult.has_value(); });
 	}
 
-	return CROSSAUDIO_EC_OK;
-}
+	// Checked again with the mainloop locked, the callback may have been called in the meantime.
+	const auto lock = locker();
 
-ErrorCode Flux::stop() {
-	const auto lock = m_engine.locker();
+	std::optional< bool > result;
+	{
+		const std::unique_lock moveLock(m_moveLock);
+		result = m_moveResult;
+	}
 
-	if (m_stream) {
-		lib().stream_unref(m_stream);
-		m_stream = nullptr;
+	if (!result) {
+		// The callback must not be called after we return, we're possibly about to be destroyed.
+		lib().operation_cancel(operation);
 	}
 
-	return CROSSAUDIO_EC_OK;
+	lib().operation_unref(operation);
+
+	if (!result) {
+		return CROSSAUDIO_EC_TIMEOUT;
+	}
+
+	return *result ? CROSSAUDIO_EC_OK : CROSSAUDIO_EC_GENERIC;
 }
 
-ErrorCode Flux::pause(const bool on) {
-	const auto lock = m_engine.locker();
+ErrorCode Flux::volumeSet(const float volume) {
+	m_gain.volumeSet(volume);
 
-	lib().operation_unref(lib().stream_cork(m_stream, on, nullptr, nullptr));
+	return CROSSAUDIO_EC_OK;
+}
+
+ErrorCode Flux::muteSet(const bool on) {
+	m_gain.muteSet(on);
 
 	return CROSSAUDIO_EC_OK;
 }
@@ -133,7 +309,7 @@ const char *Flux::nameGet() const {
 ErrorCode Flux::nameSet(const char *name) {
 	m_name = name;
 
-	const auto lock = m_engine.locker();
+	const auto lock = locker();
 
 	lib().stream_set_name(m_stream, name, nullptr, nullptr);
 
@@ -142,22 +318,64 @@ ErrorCode Flux::nameSet(const char *name) {
 
 void Flux::processInput(size_t bytes) {
 	const void *data;
-	if (lib().stream_peek(m_stream, &data, &bytes) < 0) {
-		return;
+
+	// The callback is only issued when new data arrives, we have to consume all fragments that are available.
+	while (lib().stream_peek(m_stream, &data, &bytes) >= 0 && bytes) {
+		// A hole (no data) is delivered as silence, of the same length.
+		const auto fragment = static_cast< const std::byte * >(data);
+
+		size_t offset = 0;
+
+		// Complete the frame that the previous fragment ended in the middle of.
+		if (m_carrySize) {
+			offset = std::min(bytes, m_carry.size() - m_carrySize);
+			append(fragment, offset);
+
+			if (m_carrySize == m_carry.size()) {
+				m_gain.apply(m_carry.data(), 1);
+
+				FluxData fluxData = { m_carry.data(), 1, timing(), 0 };
+				m_feedback.process(m_feedback.userData, &fluxData);
+
+				m_carrySize = 0;
+			}
+		}
+
+		if (const uint32_t frames = (bytes - offset) / m_frameSize) {
+			void *frameData = fragment ? const_cast< std::byte * >(fragment + offset) : nullptr;
+
+			if (frameData && !m_gain.unity()) {
+				const size_t size = m_frameSize * frames;
+				if (m_scratch.size() < size) {
+					m_scratch.resize(size);
+				}
+
+				std::memcpy(m_scratch.data(), frameData, size);
+				m_gain.apply(m_scratch.data(), frames);
+
+				frameData = m_scratch.data();
+			}
+
+			FluxData fluxData = { frameData, frames, timing(), 0 };
+			m_feedback.process(m_feedback.userData, &fluxData);
+
+			offset += m_frameSize * frames;
+		}
+
+		append(fragment ? fragment + offset : nullptr, bytes - offset);
+
+		lib().stream_drop(m_stream);
 	}
+}
 
+void Flux::append(const std::byte *data, const size_t bytes) {
 	if (data) {
-		FluxData fluxData = { const_cast< void * >(data), static_cast< uint32_t >(bytes / m_frameSize) };
-
-		m_feedback.process(m_feedback.userData, &fluxData);
-	} else if (!bytes) {
-		// According to the official documentation:
-		// 1. We should not call pa_stream_drop() if the buffer is empty.
-		// 2. We should call pa_stream_drop() if there is a "hole". 'bytes' represents its size when not 0.
-		return;
+		std::memcpy(m_carry.data() + m_carrySize, data, bytes);
+	} else {
+		std::memset(m_carry.data() + m_carrySize, 0, bytes);
 	}
 
-	lib().stream_drop(m_stream);
+	m_carrySize += bytes;
 }
 
 void Flux::processOutput(size_t bytes) {
@@ -166,19 +384,89 @@ void Flux::processOutput(size_t bytes) {
 		return;
 	}
 
-	FluxData fluxData = { data, static_cast< uint32_t >(bytes / m_frameSize) };
+	FluxData fluxData = { data, static_cast< uint32_t >(bytes / m_frameSize), timing(), 0 };
 
 	m_feedback.process(m_feedback.userData, &fluxData);
 
 	if (fluxData.frames) {
-		bytes = m_frameSize * fluxData.frames;
-	} else {
-		// Telling PulseAudio that we wrote 0 bytes results in an xrun,
-		// which in turn results in this function not being called anymore.
-		memset(data, 0, bytes);
+		m_gain.apply(data, fluxData.frames);
+
+		lib().stream_write(m_stream, data, m_frameSize * fluxData.frames, nullptr, 0, PA_SEEK_RELATIVE);
+		return;
+	}
+
+	// Telling PulseAudio that we wrote 0 bytes results in an xrun,
+	// which in turn results in this function not being called anymore.
+	// Instead of filling the whole request, we only queue the smallest amount the server asks for.
+	lib().stream_cancel_write(m_stream);
+	lib().stream_write(m_stream, m_silence.data(), std::min(bytes, m_silence.size()), nullptr, 0, PA_SEEK_RELATIVE);
+}
+
+FluxTiming Flux::timing() const {
+	FluxTiming timing = {};
+
+	// Both fail until the first timing update is received.
+	pa_usec_t usec;
+	if (lib().stream_get_time(m_stream, &usec) >= 0) {
+		timing.position = usec * m_sampleRate / USEC_PER_SEC;
+	}
+
+	// Negative for capture streams when we're reading data faster than it's recorded (e.g. after a rewind).
+	int negative;
+	if (lib().stream_get_latency(m_stream, &usec, &negative) >= 0) {
+		timing.delay = static_cast< int64_t >(usec * m_sampleRate / USEC_PER_SEC) * (negative ? -1 : 1);
 	}
 
-	lib().stream_write(m_stream, data, bytes, nullptr, 0, PA_SEEK_RELATIVE);
+	return timing;
+}
+
+void Flux::streamState(pa_stream *stream, void *userData) {
+	auto &flux = *static_cast< Flux * >(userData);
+
+	switch (lib().stream_get_state(stream)) {
+		case PA_STREAM_READY:
+			// Called before the first write request: the silence has to match the granted minimum request.
+			if (flux.m_direction == CROSSAUDIO_DIR_OUT) {
+				if (const auto bufferAttr = lib().stream_get_buffer_attr(stream)) {
+					flux.m_silence.assign(bufferAttr->minreq, std::byte(0));
+				}
+			}
+			[[fallthrough]];
+		case PA_STREAM_FAILED:
+		case PA_STREAM_TERMINATED:
+			flux.m_connectComplete.test_and_set();
+			flux.m_connectComplete.notify_all();
+		default:
+			break;
+	}
+}
+
+void Flux::moveComplete(pa_context *, const int success, void *userData) {
+	auto &flux = *static_cast< Flux * >(userData);
+
+	{
+		const std::unique_lock lock(flux.m_moveLock);
+		flux.m_moveResult = success;
+	}
+
+	flux.m_moveCond.notify_all();
+}
+
+static constexpr pa_buffer_attr configToAttr(const FluxConfig &config, const uint32_t frameSize) {
+	// 10 ms by default.
+	const uint32_t period  = config.period ? config.period : config.sampleRate / 100;
+	const uint32_t latency = config.latency ? config.latency : period;
+
+	pa_buffer_attr ret;
+
+	ret.maxlength = static_cast< decltype(ret.maxlength) >(-1);
+	ret.tlength   = frameSize * latency;
+	ret.prebuf    = static_cast< decltype(ret.prebuf) >(-1);
+	ret.minreq    = frameSize * period;
+	// Capture streams have a single attribute: it sets both the callback size and (when adjusting) the latency.
+	ret.fragsize = frameSize * period;
+
+	return ret;
 }
 
 static constexpr pa_channel_map configToMap(const FluxConfig &config) {
@@ -226,6 +514,20 @@ static constexpr pa_sample_format translateFormat(const CrossAudio_BitFormat for
 	return PA_SAMPLE_INVALID;
 }
 
+static constexpr pa_stream_flags_t translateFlags(const uint32_t flags) {
+	uint32_t ret = PA_STREAM_NOFLAGS;
+
+	if (flags & CROSSAUDIO_FF_ADJUST_LATENCY) {
+		ret |= PA_STREAM_ADJUST_LATENCY;
+	}
+
+	if (flags & CROSSAUDIO_FF_EARLY_REQUESTS) {
+		ret |= PA_STREAM_EARLY_REQUESTS;
+	}
+
+	return static_cast< pa_stream_flags_t >(ret);
+}
+
 static constexpr pa_channel_position translateChannel(const CrossAudio_Channel channel) {
 	switch (channel) {
 		default:
@@ -6,20 +6,34 @@
 #ifndef CROSSAUDIO_SRC_BACKENDS_PULSEAUDIO_FLUX_HPP
 #define CROSSAUDIO_SRC_BACKENDS_PULSEAUDIO_FLUX_HPP
 
+#include "Gain.hpp"
+
 #include "crossaudio/ErrorCode.h"
 #include "crossaudio/Flux.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <vector>
 
+typedef CrossAudio_Direction Direction;
 typedef CrossAudio_ErrorCode ErrorCode;
 
 typedef CrossAudio_FluxConfig FluxConfig;
 typedef CrossAudio_FluxFeedback FluxFeedback;
+typedef CrossAudio_FluxTiming FluxTiming;
 
+struct pa_context;
 struct pa_stream;
+struct pa_threaded_mainloop;
 
 namespace pulseaudio {
+class Dispatcher;
 class Engine;
 
 class Flux {
@@ -33,21 +47,66 @@ public:
 	ErrorCode start(FluxConfig &config, const FluxFeedback &feedback);
 	ErrorCode stop();
 	ErrorCode pause(bool on);
+	ErrorCode move(const char *node);
+
+	ErrorCode volumeSet(float volume);
+	ErrorCode muteSet(bool on);
 
 private:
+	class Locker {
+	public:
+		Locker(pa_threaded_mainloop *threadLoop);
+		~Locker();
+
+	private:
+		pa_threaded_mainloop *m_threadLoop;
+	};
+
 	Flux(const Flux &)            = delete;
 	Flux &operator=(const Flux &) = delete;
 
+	Locker locker() { return Locker(m_threadLoop); };
+
 	void processInput(size_t bytes);
 	void processOutput(size_t bytes);
 
+	void append(const std::byte *data, size_t bytes);
+
+	FluxTiming timing() const;
+
+	static void streamState(pa_stream *stream, void *userData);
+	static void moveComplete(pa_context *context, int success, void *userData);
+
 	Engine &m_engine;
 	FluxFeedback m_feedback;
-
+	Direction m_direction;
+
+	// Either the engine's or a dedicated dispatcher's, depending on the flux's group.
+	std::shared_ptr< Dispatcher > m_dispatcher;
+	pa_threaded_mainloop *m_threadLoop;
+	pa_context *m_context;
+
+	std::atomic_flag m_connectComplete;
+	// Unlike the connection, a move can be waited for with a timeout.
+	std::mutex m_moveLock;
+	std::condition_variable m_moveCond;
+	std::optional< bool > m_moveResult;
 	pa_stream *m_stream;
 	std::string m_name;
 
 	uint32_t m_frameSize;
+	uint32_t m_sampleRate;
+
+	// Fragments are not guaranteed to end on a frame boundary, the partial frame is completed by the next one.
+	std::vector< std::byte > m_carry;
+	size_t m_carrySize;
+
+	// Written when the application has nothing to play, zeroed once.
+	std::vector< std::byte > m_silence;
+
+	Gain m_gain;
+	// Captured samples are scaled here, the ones handed out by the server are read-only.
+	std::vector< std::byte > m_scratch;
 };
 } // namespace pulseaudio
 
@@ -0,0 +1,145 @@
+// Copyright The Mumble Developers. All rights reserved.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Gain.hpp"
+
+#include <algorithm>
+#include <limits>
+
+using namespace pulseaudio;
+
+// Integer samples are scaled in double precision (32 bit ones don't fit in a float's mantissa) and clamped.
+// The kernels are branchless per sample, so that the compiler can vectorize them.
+
+template< typename T, int64_t min, int64_t max, int64_t bias > struct IntSample {
+	typedef T Type;
+
+	static T scale(const T sample, const float gain) {
+		const double value = (static_cast< double >(sample) - bias) * gain;
+		return static_cast< T >((value < max ? (value > min ? value : min) : max) + bias);
+	}
+};
+
+struct FloatSample {
+	typedef float Type;
+
+	static float scale(const float sample, const float gain) { return sample * gain; }
+};
+
+typedef IntSample< uint8_t, -128, 127, 128 > U8;
+typedef IntSample< int16_t, std::numeric_limits< int16_t >::min(), std::numeric_limits< int16_t >::max(), 0 > S16;
+typedef IntSample< int32_t, -(1 << 23), (1 << 23) - 1, 0 > S24_32;
+typedef IntSample< int32_t, std::numeric_limits< int32_t >::min(), std::numeric_limits< int32_t >::max(), 0 > S32;
+
+template< typename Sample > static void scale(void *data, const size_t samples, const float gain) {
+	auto buffer = static_cast< typename Sample::Type * >(data);
+
+	for (size_t i = 0; i < samples; ++i) {
+		buffer[i] = Sample::scale(buffer[i], gain);
+	}
+}
+
+template< typename Sample >
+static void ramp(void *data, const size_t frames, const uint8_t channels, float gain, const float step) {
+	auto buffer = static_cast< typename Sample::Type * >(data);
+
+	for (size_t i = 0; i < frames; ++i, gain += step) {
+		for (uint8_t j = 0; j < channels; ++j, ++buffer) {
+			*buffer = Sample::scale(*buffer, gain);
+		}
+	}
+}
+
+Gain::Gain()
+	: m_scale(nullptr), m_ramp(nullptr), m_frameSize(0), m_channels(0), m_rampFrames(0), m_volume(1.f),
+	  m_mute(false), m_current(1.f), m_target(1.f), m_step(0.f), m_rampLeft(0) {
+}
+
+bool Gain::setup(const pa_sample_format format, const uint8_t channels, const uint32_t rampFrames) {
+	uint8_t sampleSize;
+
+	switch (format) {
+		case PA_SAMPLE_U8:
+			m_scale    = scale< U8 >;
+			m_ramp     = ramp< U8 >;
+			sampleSize = sizeof(U8::Type);
+			break;
+		case PA_SAMPLE_S16NE:
+			m_scale    = scale< S16 >;
+			m_ramp     = ramp< S16 >;
+			sampleSize = sizeof(S16::Type);
+			break;
+		case PA_SAMPLE_S24_32NE:
+			m_scale    = scale< S24_32 >;
+			m_ramp     = ramp< S24_32 >;
+			sampleSize = sizeof(S24_32::Type);
+			break;
+		case PA_SAMPLE_S32NE:
+			m_scale    = scale< S32 >;
+			m_ramp     = ramp< S32 >;
+			sampleSize = sizeof(S32::Type);
+			break;
+		case PA_SAMPLE_FLOAT32NE:
+			m_scale    = scale< FloatSample >;
+			m_ramp     = ramp< FloatSample >;
+			sampleSize = sizeof(FloatSample::Type);
+			break;
+		default:
+			return false;
+	}
+
+	m_frameSize  = sampleSize * channels;
+	m_channels   = channels;
+	m_rampFrames = std::max(rampFrames, 1u);
+
+	// The flux starts at the requested volume, without ramping.
+	m_current = m_target = target();
+	m_rampLeft           = 0;
+
+	return true;
+}
+
+void Gain::volumeSet(const float volume) {
+	// Also takes care of NaN.
+	m_volume.store(volume > 0.f ? volume : 0.f, std::memory_order_relaxed);
+}
+
+void Gain::muteSet(const bool on) {
+	m_mute.store(on, std::memory_order_relaxed);
+}
+
+bool Gain::unity() const {
+	return !m_rampLeft && m_current == 1.f && target() == 1.f;
+}
+
+void Gain::apply(void *data, uint32_t frames) {
+	if (const float target = this->target(); target != m_target) {
+		m_target   = target;
+		m_step     = (target - m_current) / m_rampFrames;
+		m_rampLeft = m_rampFrames;
+	}
+
+	auto buffer = static_cast< std::byte * >(data);
+
+	if (m_rampLeft) {
+		const uint32_t count = std::min(frames, m_rampLeft);
+
+		m_ramp(buffer, count, m_channels, m_current, m_step);
+
+		m_rampLeft -= count;
+		m_current = m_rampLeft ? m_current + m_step * count : m_target;
+
+		buffer += m_frameSize * count;
+		frames -= count;
+	}
+
+	if (frames && m_current != 1.f) {
+		m_scale(buffer, static_cast< size_t >(frames) * m_channels, m_current);
+	}
+}
+
+float Gain::target() const {
+	return m_mute.load(std::memory_order_relaxed) ? 0.f : m_volume.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,53 @@
+// Copyright The Mumble Developers. All rights reserved.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef CROSSAUDIO_SRC_BACKENDS_PULSEAUDIO_GAIN_HPP
+#define CROSSAUDIO_SRC_BACKENDS_PULSEAUDIO_GAIN_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <pulse/sample.h>
+
+namespace pulseaudio {
+// Volume and mute applied to the samples in-process, so that changes take effect without a server round-trip.
+// The target can be set from any thread, the callback thread ramps towards it linearly to avoid clicks.
+class Gain {
+public:
+	Gain();
+
+	bool setup(pa_sample_format format, uint8_t channels, uint32_t rampFrames);
+
+	void volumeSet(float volume);
+	void muteSet(bool on);
+
+	// Only called by the callback thread.
+	bool unity() const;
+	void apply(void *data, uint32_t frames);
+
+private:
+	typedef void (*ScaleFunc)(void *data, size_t samples, float gain);
+	typedef void (*RampFunc)(void *data, size_t frames, uint8_t channels, float gain, float step);
+
+	float target() const;
+
+	ScaleFunc m_scale;
+	RampFunc m_ramp;
+	uint32_t m_frameSize;
+	uint8_t m_channels;
+	uint32_t m_rampFrames;
+
+	std::atomic< float > m_volume;
+	std::atomic_bool m_mute;
+
+	float m_current;
+	float m_target;
+	float m_step;
+	uint32_t m_rampLeft;
+};
+} // namespace pulseaudio
+
+#endif
@@ -30,6 +30,7 @@ ErrorCode Library::load(const std::string_view libraryName) {
 
 	LOAD_SYM(get_library_version)
 
+	LOAD_SYM(operation_cancel)
 	LOAD_SYM(operation_unref)
 
 	LOAD_SYM(context_new_with_proplist)
@@ -43,6 +44,8 @@ ErrorCode Library::load(const std::string_view libraryName) {
 	LOAD_SYM(context_get_source_info_by_index)
 	LOAD_SYM(context_get_sink_info_list)
 	LOAD_SYM(context_get_source_info_list)
+	LOAD_SYM(context_move_sink_input_by_index)
+	LOAD_SYM(context_move_source_output_by_index)
 	LOAD_SYM(context_set_name)
 	LOAD_SYM(context_set_state_callback)
 	LOAD_SYM(context_set_subscribe_callback)
@@ -56,14 +59,21 @@ ErrorCode Library::load(const std::string_view libraryName) {
 	LOAD_SYM(stream_connect_playback)
 	LOAD_SYM(stream_connect_record)
 	LOAD_SYM(stream_disconnect)
+	LOAD_SYM(stream_get_state)
+	LOAD_SYM(stream_get_index)
+	LOAD_SYM(stream_get_buffer_attr)
+	LOAD_SYM(stream_get_time)
+	LOAD_SYM(stream_get_latency)
 	LOAD_SYM(stream_cork)
 	LOAD_SYM(stream_peek)
 	LOAD_SYM(stream_begin_write)
+	LOAD_SYM(stream_cancel_write)
 	LOAD_SYM(stream_write)
 	LOAD_SYM(stream_drop)
 	LOAD_SYM(stream_set_name)
 	LOAD_SYM(stream_set_read_callback)
 	LOAD_SYM(stream_set_write_callback)
+	LOAD_SYM(stream_set_state_callback)
 
 	LOAD_SYM(threaded_mainloop_new)
 	LOAD_SYM(threaded_mainloop_free)
@@ -73,6 +83,8 @@ ErrorCode Library::load(const std::string_view libraryName) {
 	LOAD_SYM(threaded_mainloop_stop)
 	LOAD_SYM(threaded_mainloop_get_api)
 
+	LOAD_SYM(mainloop_api_once)
+
 	return CROSSAUDIO_EC_OK;
 }
 
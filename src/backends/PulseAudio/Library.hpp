@@ -35,6 +35,7 @@ public:
 
 	const char *(*get_library_version)();
 
+	void (*operation_cancel)(pa_operation *o);
 	void (*operation_unref)(pa_operation *o);
 
 	pa_context *(*context_new_with_proplist)(pa_mainloop_api *mainloop, const char *name, const pa_proplist *proplist);
@@ -50,6 +51,10 @@ public:
 													  void *userdata);
 	pa_operation *(*context_get_sink_info_list)(pa_context *c, pa_sink_info_cb_t cb, void *userdata);
 	pa_operation *(*context_get_source_info_list)(pa_context *c, pa_source_info_cb_t cb, void *userdata);
+	pa_operation *(*context_move_sink_input_by_index)(pa_context *c, uint32_t idx, const char *sink_name,
+													  pa_context_success_cb_t cb, void *userdata);
+	pa_operation *(*context_move_source_output_by_index)(pa_context *c, uint32_t idx, const char *source_name,
+														 pa_context_success_cb_t cb, void *userdata);
 	pa_operation *(*context_set_name)(pa_context *c, const char *name, pa_context_success_cb_t cb, void *userdata);
 	void (*context_set_state_callback)(pa_context *c, pa_context_notify_cb_t cb, void *userdata);
 	void (*context_set_subscribe_callback)(pa_context *c, pa_context_subscribe_cb_t cb, void *userdata);
@@ -64,15 +69,22 @@ public:
 								   const pa_cvolume *volume, pa_stream *sync_stream);
 	int (*stream_connect_record)(pa_stream *s, const char *dev, const pa_buffer_attr *attr, pa_stream_flags_t flags);
 	int (*stream_disconnect)(pa_stream *s);
+	pa_stream_state_t (*stream_get_state)(const pa_stream *p);
+	uint32_t (*stream_get_index)(const pa_stream *s);
+	const pa_buffer_attr *(*stream_get_buffer_attr)(pa_stream *s);
+	int (*stream_get_time)(pa_stream *s, pa_usec_t *r_usec);
+	int (*stream_get_latency)(pa_stream *s, pa_usec_t *r_usec, int *negative);
 	pa_operation *(*stream_cork)(pa_stream *s, int b, pa_stream_success_cb_t cb, void *userdata);
 	int (*stream_peek)(pa_stream *p, const void **data, size_t *nbytes);
 	int (*stream_begin_write)(pa_stream *p, void **data, size_t *nbytes);
+	int (*stream_cancel_write)(pa_stream *p);
 	int (*stream_write)(pa_stream *p, const void *data, size_t nbytes, pa_free_cb_t free_cb, int64_t offset,
 						pa_seek_mode_t seek);
 	int (*stream_drop)(pa_stream *p);
 	pa_operation *(*stream_set_name)(pa_stream *s, const char *name, pa_stream_success_cb_t cb, void *userdata);
 	void (*stream_set_read_callback)(pa_stream *p, pa_stream_request_cb_t cb, void *userdata);
 	void (*stream_set_write_callback)(pa_stream *p, pa_stream_request_cb_t cb, void *userdata);
+	void (*stream_set_state_callback)(pa_stream *s, pa_stream_notify_cb_t cb, void *userdata);
 
 	pa_threaded_mainloop *(*threaded_mainloop_new)();
 	void (*threaded_mainloop_free)(pa_threaded_mainloop *m);
@@ -82,6 +94,8 @@ public:
 	void (*threaded_mainloop_stop)(pa_threaded_mainloop *m);
 	pa_mainloop_api *(*threaded_mainloop_get_api)(pa_threaded_mainloop *m);
 
+	void (*mainloop_api_once)(pa_mainloop_api *m, void (*callback)(pa_mainloop_api *m, void *userdata), void *userdata);
+
 private:
 	Library();
 	~Library();
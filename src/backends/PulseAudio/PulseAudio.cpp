@@ -77,7 +77,11 @@ static ErrorCode engineFree(BE_Engine *engine) {
 }
 
 static ErrorCode engineStart(BE_Engine *engine, const EngineFeedback *feedback) {
-	return toImpl(engine)->start(feedback ? *feedback : EngineFeedback());
+	return toImpl(engine)->start(feedback ? *feedback : EngineFeedback(), false);
+}
+
+static ErrorCode engineStartAsync(BE_Engine *engine, const EngineFeedback *feedback) {
+	return toImpl(engine)->start(*feedback, true);
 }
 
 static ErrorCode engineStop(BE_Engine *engine) {
@@ -96,6 +100,10 @@ static Nodes *engineNodesGet(BE_Engine *engine) {
 	return toImpl(engine)->engineNodesGet();
 }
 
+static ::Node *engineDefaultNodeGet(BE_Engine *engine, const Direction direction) {
+	return toImpl(engine)->defaultNodeGet(direction);
+}
+
 static BE_Flux *fluxNew(BE_Engine *engine) {
 	return reinterpret_cast< BE_Flux * >(new Flux(*toImpl(engine)));
 }
@@ -118,6 +126,18 @@ static ErrorCode fluxPause(BE_Flux *flux, const bool on) {
 	return toImpl(flux)->pause(on);
 }
 
+static ErrorCode fluxMove(BE_Flux *flux, const char *node) {
+	return toImpl(flux)->move(node);
+}
+
+static ErrorCode fluxVolumeSet(BE_Flux *flux, const float volume) {
+	return toImpl(flux)->volumeSet(volume);
+}
+
+static ErrorCode fluxMuteSet(BE_Flux *flux, const bool on) {
+	return toImpl(flux)->muteSet(on);
+}
+
 static const char *fluxNameGet(BE_Flux *flux) {
 	return toImpl(flux)->nameGet();
 }
@@ -148,6 +168,14 @@ constexpr BE_Impl PulseAudio_Impl = {
 	fluxStop,
 	fluxPause,
 	fluxNameGet,
-	fluxNameSet
+	fluxNameSet,
+
+	nullptr,
+	engineStartAsync,
+	fluxVolumeSet,
+	fluxMuteSet,
+	fluxMove,
+	nullptr,
+	engineDefaultNodeGet
 };
 // clang-format on
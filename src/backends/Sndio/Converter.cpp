@@ -0,0 +1,214 @@
+// Copyright The Mumble Developers. All rights reserved.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Converter.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+
+#include <sndio.h>
+
+using namespace sndio;
+
+static constexpr size_t CHUNK_SAMPLES = 1024;
+
+static constexpr uint32_t SIGN_BIT = 0x80000000;
+
+// The kernels below are branchless per sample, so that the compiler can vectorize them.
+
+template< typename T > static void unpackNative(int32_t *dst, const T *src, const size_t samples, const uint8_t shift,
+												const uint32_t flip) {
+	for (size_t i = 0; i < samples; ++i) {
+		dst[i] = static_cast< int32_t >((static_cast< uint32_t >(src[i]) << shift) ^ flip);
+	}
+}
+
+template< typename T > static void packNative(T *dst, const int32_t *src, const size_t samples, const uint8_t shift,
+											  const uint32_t flip) {
+	// Signed samples are shifted arithmetically so that they're sign-extended within the container.
+	for (size_t i = 0; i < samples; ++i) {
+		const uint32_t value   = static_cast< uint32_t >(src[i]) ^ flip;
+		const int32_t extended = static_cast< int32_t >(value) >> shift;
+
+		dst[i] = static_cast< T >(flip ? value >> shift : static_cast< uint32_t >(extended));
+	}
+}
+
+static void toFloat(float *dst, const int32_t *src, const size_t samples) {
+	constexpr float scale = 1.f / 2147483648.f;
+
+	for (size_t i = 0; i < samples; ++i) {
+		dst[i] = static_cast< float >(src[i]) * scale;
+	}
+}
+
+static void fromFloat(int32_t *dst, const float *src, const size_t samples) {
+	constexpr double min = std::numeric_limits< int32_t >::min();
+	constexpr double max = std::numeric_limits< int32_t >::max();
+
+	for (size_t i = 0; i < samples; ++i) {
+		const double value = static_cast< double >(src[i]) * -min;
+		// Written so that NaN is clamped rather than being cast (undefined behavior).
+		dst[i] = static_cast< int32_t >(value < max ? (value > min ? value : min) : max);
+	}
+}
+
+Converter::Converter() : m_client(), m_device(), m_passthrough(true) {
+}
+
+bool Converter::setup(const FluxConfig &config, const sio_par &par) {
+	switch (config.bitFormat) {
+		case CROSSAUDIO_BF_INTEGER_SIGNED:
+		case CROSSAUDIO_BF_INTEGER_UNSIGNED:
+			if (!config.sampleBits || config.sampleBits > 32) {
+				return false;
+			}
+
+			m_client.size    = std::bit_ceil(config.sampleBits) / 8;
+			m_client.shift   = 32 - config.sampleBits;
+			m_client.flip    = config.bitFormat == CROSSAUDIO_BF_INTEGER_UNSIGNED ? SIGN_BIT : 0;
+			m_client.isFloat = false;
+			break;
+		case CROSSAUDIO_BF_FLOAT:
+			if (config.sampleBits != 32) {
+				return false;
+			}
+
+			m_client.size    = sizeof(float);
+			m_client.shift   = 0;
+			m_client.flip    = 0;
+			m_client.isFloat = true;
+			break;
+		default:
+			return false;
+	}
+
+	m_client.native = true;
+	m_client.le     = SIO_LE_NATIVE;
+
+	if (!par.bps || par.bps > 4 || !par.bits || par.bits > par.bps * 8) {
+		return false;
+	}
+
+	// When "bits" is smaller than the container, "msb" tells us whether the sample is stored in the upper bits.
+	m_device.size    = par.bps;
+	m_device.shift   = par.msb ? 32 - par.bps * 8 : 32 - par.bits;
+	m_device.flip    = par.sig ? 0 : SIGN_BIT;
+	m_device.le      = par.le;
+	m_device.native  = par.bps != 3 && (par.bps == 1 || par.le == SIO_LE_NATIVE);
+	m_device.isFloat = false;
+
+	m_passthrough = !m_client.isFloat && m_device.native && m_client.size == m_device.size
+					&& m_client.shift == m_device.shift && m_client.flip == m_device.flip;
+
+	return true;
+}
+
+void Converter::toClient(void *dst, const void *src, const size_t samples) const {
+	std::array< int32_t, CHUNK_SAMPLES > chunk;
+
+	auto in  = static_cast< const std::byte * >(src);
+	auto out = static_cast< std::byte * >(dst);
+
+	for (size_t done = 0; done < samples;) {
+		const size_t count = std::min(samples - done, chunk.size());
+
+		unpack(chunk.data(), in, count, m_device);
+
+		if (m_client.isFloat) {
+			toFloat(reinterpret_cast< float * >(out), chunk.data(), count);
+		} else {
+			pack(out, chunk.data(), count, m_client);
+		}
+
+		in += count * m_device.size;
+		out += count * m_client.size;
+		done += count;
+	}
+}
+
+void Converter::toDevice(void *dst, const void *src, const size_t samples) const {
+	std::array< int32_t, CHUNK_SAMPLES > chunk;
+
+	auto in  = static_cast< const std::byte * >(src);
+	auto out = static_cast< std::byte * >(dst);
+
+	for (size_t done = 0; done < samples;) {
+		const size_t count = std::min(samples - done, chunk.size());
+
+		if (m_client.isFloat) {
+			fromFloat(chunk.data(), reinterpret_cast< const float * >(in), count);
+		} else {
+			unpack(chunk.data(), in, count, m_client);
+		}
+
+		pack(out, chunk.data(), count, m_device);
+
+		in += count * m_client.size;
+		out += count * m_device.size;
+		done += count;
+	}
+}
+
+void Converter::unpack(int32_t *dst, const void *src, const size_t samples, const Layout &layout) {
+	if (layout.native) {
+		switch (layout.size) {
+			case 1:
+				return unpackNative(dst, static_cast< const uint8_t * >(src), samples, layout.shift, layout.flip);
+			case 2:
+				return unpackNative(dst, static_cast< const uint16_t * >(src), samples, layout.shift, layout.flip);
+			case 4:
+				return unpackNative(dst, static_cast< const uint32_t * >(src), samples, layout.shift, layout.flip);
+		}
+	}
+
+	// Packed 24 bit and foreign byte order, rare enough not to deserve dedicated kernels.
+	auto in = static_cast< const uint8_t * >(src);
+
+	for (size_t i = 0; i < samples; ++i, in += layout.size) {
+		uint32_t value = 0;
+
+		for (uint8_t j = 0; j < layout.size; ++j) {
+			if (layout.le) {
+				value |= static_cast< uint32_t >(in[j]) << (j * 8);
+			} else {
+				value = (value << 8) | in[j];
+			}
+		}
+
+		dst[i] = static_cast< int32_t >((value << layout.shift) ^ layout.flip);
+	}
+}
+
+void Converter::pack(void *dst, const int32_t *src, const size_t samples, const Layout &layout) {
+	if (layout.native) {
+		switch (layout.size) {
+			case 1:
+				return packNative(static_cast< uint8_t * >(dst), src, samples, layout.shift, layout.flip);
+			case 2:
+				return packNative(static_cast< uint16_t * >(dst), src, samples, layout.shift, layout.flip);
+			case 4:
+				return packNative(static_cast< uint32_t * >(dst), src, samples, layout.shift, layout.flip);
+		}
+	}
+
+	auto out = static_cast< uint8_t * >(dst);
+
+	for (size_t i = 0; i < samples; ++i, out += layout.size) {
+		const uint32_t flipped = static_cast< uint32_t >(src[i]) ^ layout.flip;
+		const int32_t extended = static_cast< int32_t >(flipped) >> layout.shift;
+		const uint32_t value   = layout.flip ? flipped >> layout.shift : static_cast< uint32_t >(extended);
+
+		for (uint8_t j = 0; j < layout.size; ++j) {
+			if (layout.le) {
+				out[j] = static_cast< uint8_t >(value >> (j * 8));
+			} else {
+				out[j] = static_cast< uint8_t >(value >> ((layout.size - 1 - j) * 8));
+			}
+		}
+	}
+}
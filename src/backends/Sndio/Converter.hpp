@@ -0,0 +1,54 @@
+// Copyright The Mumble Developers. All rights reserved.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef CROSSAUDIO_SRC_BACKENDS_SNDIO_CONVERTER_HPP
+#define CROSSAUDIO_SRC_BACKENDS_SNDIO_CONVERTER_HPP
+
+#include "crossaudio/Flux.h"
+
+#include <cstddef>
+#include <cstdint>
+
+typedef CrossAudio_FluxConfig FluxConfig;
+
+struct sio_par;
+
+namespace sndio {
+// Translates samples between the format requested by the client and the (integer) encoding chosen by the device.
+// Both sides are expanded to left-justified 32 bit integers in between, in small chunks that stay in the L1 cache.
+class Converter {
+public:
+	Converter();
+
+	bool setup(const FluxConfig &config, const sio_par &par);
+
+	constexpr bool passthrough() const { return m_passthrough; }
+
+	constexpr uint8_t clientSampleSize() const { return m_client.size; }
+	constexpr uint8_t deviceSampleSize() const { return m_device.size; }
+
+	void toClient(void *dst, const void *src, size_t samples) const;
+	void toDevice(void *dst, const void *src, size_t samples) const;
+
+private:
+	struct Layout {
+		uint8_t size;
+		uint8_t shift;
+		uint32_t flip;
+		bool native;
+		bool le;
+		bool isFloat;
+	};
+
+	static void unpack(int32_t *dst, const void *src, size_t samples, const Layout &layout);
+	static void pack(void *dst, const int32_t *src, size_t samples, const Layout &layout);
+
+	Layout m_client;
+	Layout m_device;
+	bool m_passthrough;
+};
+} // namespace sndio
+
+#endif
@@ -5,10 +5,315 @@
 
 #include "Engine.hpp"
 
+#include "Flux.hpp"
+#include "Library.hpp"
+
+#include "Node.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <utility>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <sndio.h>
+
 using namespace sndio;
 
-Engine::Engine() {
+// Number of units probed for each device type: "snd/N" (sndiod) and "rsnd/N" (raw hardware).
+static constexpr uint8_t MAX_UNITS = 8;
+
+struct Slot {
+	Flux *flux;
+	size_t offset;
+};
+
+Engine::Engine() : m_halt(false), m_generation(0), m_wakeFds{ -1, -1 } {
+	if (pipe(m_wakeFds) != 0) {
+		m_wakeFds[0] = m_wakeFds[1] = -1;
+		return;
+	}
+
+	// A full pipe already guarantees a wake-up, writes can be dropped.
+	for (const auto fd : m_wakeFds) {
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+		fcntl(fd, F_SETFD, FD_CLOEXEC);
+	}
 }
 
 Engine::~Engine() {
+	stopThread();
+	stop();
+
+	for (const auto fd : m_wakeFds) {
+		if (fd >= 0) {
+			close(fd);
+		}
+	}
+}
+
+ErrorCode Engine::start() {
+	// Opening a device can take a while (especially when a server is involved), probe them all concurrently.
+	std::vector< std::future< std::optional< Node > > > probes;
+
+	for (const std::string prefix : { "snd/", "rsnd/" }) {
+		for (uint8_t i = 0; i < MAX_UNITS; ++i) {
+			probes.push_back(std::async(std::launch::async, probeNode, prefix + std::to_string(i)));
+		}
+	}
+
+	m_nodes.clear();
+
+	for (auto &probe : probes) {
+		if (auto node = probe.get()) {
+			m_nodes.push_back(std::move(*node));
+		}
+	}
+
+	return CROSSAUDIO_EC_OK;
+}
+
+ErrorCode Engine::stop() {
+	m_nodes.clear();
+
+	return CROSSAUDIO_EC_OK;
+}
+
+void Engine::addFlux(Flux &flux) {
+	{
+		const std::lock_guard lock(m_fluxesLock);
+
+		m_fluxes.push_back(&flux);
+
+		if (!m_thread) {
+			m_halt   = false;
+			m_thread = std::make_unique< std::thread >(&Engine::process, this);
+		}
+	}
+
+	wake();
+}
+
+void Engine::removeFlux(Flux &flux) {
+	uint64_t generation;
+
+	{
+		const std::lock_guard lock(m_fluxesLock);
+
+		const auto iter = std::find(m_fluxes.cbegin(), m_fluxes.cend(), &flux);
+		if (iter == m_fluxes.cend()) {
+			return;
+		}
+
+		m_fluxes.erase(iter);
+
+		if (!m_thread || m_thread->get_id() == std::this_thread::get_id()) {
+			return;
+		}
+
+		generation = m_generation;
+	}
+
+	// The thread may be polling the flux's descriptors, wait for it to start over without them.
+	wake();
+	m_generation.wait(generation);
+}
+
+void Engine::wake() {
+	const char byte = 0;
+	[[maybe_unused]] const auto ret = write(m_wakeFds[1], &byte, sizeof(byte));
+}
+
+void Engine::stopThread() {
+	if (!m_thread) {
+		return;
+	}
+
+	m_halt = true;
+	wake();
+
+	m_thread->join();
+	m_thread.reset();
+
+	// Release anyone still waiting in removeFlux().
+	++m_generation;
+	m_generation.notify_all();
+}
+
+void Engine::process() {
+	std::vector< PollFD > fds;
+	std::vector< Slot > slots;
+
+	while (!m_halt) {
+		fds.assign(1, { m_wakeFds[0], POLLIN, 0 });
+		slots.clear();
+
+		{
+			const std::lock_guard lock(m_fluxesLock);
+
+			++m_generation;
+			m_generation.notify_all();
+
+			for (auto flux : m_fluxes) {
+				const size_t offset = fds.size();
+				fds.resize(offset + flux->nfds());
+				fds.resize(offset + flux->pollfd(fds.data() + offset));
+
+				slots.push_back({ flux, offset });
+			}
+		}
+
+		if (poll(fds.data(), fds.size(), -1) < 0) {
+			continue;
+		}
+
+		if (fds[0].revents & POLLIN) {
+			char buffer[64];
+			while (read(m_wakeFds[0], buffer, sizeof(buffer)) > 0) {
+			}
+		}
+
+		const std::lock_guard lock(m_fluxesLock);
+
+		for (const auto &slot : slots) {
+			// The flux may have been removed while we were polling.
+			const auto iter = std::find(m_fluxes.cbegin(), m_fluxes.cend(), slot.flux);
+			if (iter == m_fluxes.cend()) {
+				continue;
+			}
+
+			// The device is gone: we stop polling it and let the application know, it may stop the flux right away.
+			if (!slot.flux->process(fds.data() + slot.offset)) {
+				m_fluxes.erase(iter);
+				slot.flux->fail();
+			}
+		}
+	}
+}
+
+const char *Engine::nameGet() const {
+	return m_name.data();
+}
+
+ErrorCode Engine::nameSet(const char *name) {
+	m_name = name;
+
+	return CROSSAUDIO_EC_OK;
+}
+
+Nodes *Engine::engineNodesGet() {
+	auto nodes = nodesNew(m_nodes.size());
+
+	for (size_t i = 0; i < m_nodes.size(); ++i) {
+		const auto &nodeIn = m_nodes[i];
+		auto &nodeOut      = nodes->items[i];
+
+		nodeOut.id          = strdup(nodeIn.id.data());
+		nodeOut.name        = strdup(nodeIn.id.data());
+		nodeOut.direction   = nodeIn.direction;
+		nodeOut.minChannels = nodeIn.minChannels;
+		nodeOut.maxChannels = nodeIn.maxChannels;
+
+		nodeCapsNew(&nodeOut, nodeIn.formats.size(), nodeIn.rates.size());
+		std::copy(nodeIn.formats.cbegin(), nodeIn.formats.cend(), nodeOut.formats);
+		std::copy(nodeIn.rates.cbegin(), nodeIn.rates.cend(), nodeOut.rates);
+	}
+
+	return nodes;
+}
+
+std::optional< Engine::Node > Engine::probeNode(std::string id) {
+	Node node{ .id          = std::move(id),
+			   .direction   = CROSSAUDIO_DIR_NONE,
+			   .formats     = {},
+			   .rates       = {},
+			   .minChannels = std::numeric_limits< uint8_t >::max(),
+			   .maxChannels = 0 };
+
+	// Full-duplex handles fail on devices that only support one direction, check them separately.
+	for (const unsigned int mode : { SIO_PLAY, SIO_REC }) {
+		sio_hdl *handle = lib().open(node.id.data(), mode, 0);
+		if (!handle) {
+			continue;
+		}
+
+		sio_cap cap;
+		if (lib().getcap(handle, &cap)) {
+			parseCap(node, cap, mode);
+		}
+
+		lib().close(handle);
+
+		auto direction = static_cast< uint8_t >(node.direction);
+		direction |= mode == SIO_PLAY ? CROSSAUDIO_DIR_OUT : CROSSAUDIO_DIR_IN;
+		node.direction = static_cast< Direction >(direction);
+	}
+
+	if (node.direction == CROSSAUDIO_DIR_NONE) {
+		return std::nullopt;
+	}
+
+	if (node.minChannels > node.maxChannels) {
+		node.minChannels = 0;
+	}
+
+	std::sort(node.rates.begin(), node.rates.end());
+
+	return node;
+}
+
+void Engine::parseCap(Node &node, const sio_cap &cap, const unsigned int mode) {
+	const auto &chans = mode == SIO_PLAY ? cap.pchan : cap.rchan;
+
+	for (unsigned int i = 0; i < std::min(cap.nconf, static_cast< unsigned int >(SIO_NCONF)); ++i) {
+		const auto &conf = cap.confs[i];
+
+		for (unsigned int j = 0; j < SIO_NENC; ++j) {
+			if (!(conf.enc & (1 << j))) {
+				continue;
+			}
+
+			const auto &enc = cap.enc[j];
+			if (enc.bps > 1 && enc.le != SIO_LE_NATIVE) {
+				continue;
+			}
+
+			const NodeFormat format = { enc.sig ? CROSSAUDIO_BF_INTEGER_SIGNED : CROSSAUDIO_BF_INTEGER_UNSIGNED,
+										static_cast< uint8_t >(enc.bits) };
+
+			const auto sameFormat = [&format](const NodeFormat &other) {
+				return other.bitFormat == format.bitFormat && other.sampleBits == format.sampleBits;
+			};
+
+			if (std::none_of(node.formats.cbegin(), node.formats.cend(), sameFormat)) {
+				node.formats.push_back(format);
+			}
+		}
+
+		for (unsigned int j = 0; j < SIO_NCHAN; ++j) {
+			if (!((mode == SIO_PLAY ? conf.pchan : conf.rchan) & (1 << j))) {
+				continue;
+			}
+
+			const auto channels = static_cast< uint8_t >(std::min(chans[j], 255u));
+
+			node.minChannels = std::min(node.minChannels, channels);
+			node.maxChannels = std::max(node.maxChannels, channels);
+		}
+
+		for (unsigned int j = 0; j < SIO_NRATE; ++j) {
+			if (!(conf.rate & (1 << j))) {
+				continue;
+			}
+
+			if (std::find(node.rates.cbegin(), node.rates.cend(), cap.rate[j]) == node.rates.cend()) {
+				node.rates.push_back(cap.rate[j]);
+			}
+		}
+	}
 }
@@ -6,15 +6,82 @@
 #ifndef CROSSAUDIO_SRC_BACKENDS_SNDIO_ENGINE_HPP
 #define CROSSAUDIO_SRC_BACKENDS_SNDIO_ENGINE_HPP
 
+#include "crossaudio/Direction.h"
+#include "crossaudio/ErrorCode.h"
+#include "crossaudio/Node.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef CrossAudio_Direction Direction;
+typedef CrossAudio_ErrorCode ErrorCode;
+
+typedef CrossAudio_NodeFormat NodeFormat;
+typedef CrossAudio_Nodes Nodes;
+
+struct sio_cap;
+
 namespace sndio {
+class Flux;
+
 class Engine {
 public:
+	struct Node {
+		std::string id;
+		Direction direction;
+		std::vector< NodeFormat > formats;
+		std::vector< uint32_t > rates;
+		uint8_t minChannels;
+		uint8_t maxChannels;
+	};
+
 	Engine();
 	~Engine();
 
+	explicit operator bool() const { return m_wakeFds[0] >= 0; }
+
+	const char *nameGet() const;
+	ErrorCode nameSet(const char *name);
+
+	Nodes *engineNodesGet();
+
+	ErrorCode start();
+	ErrorCode stop();
+
+	void addFlux(Flux &flux);
+	void removeFlux(Flux &flux);
+	void wake();
+
 private:
 	Engine(const Engine &)            = delete;
 	Engine &operator=(const Engine &) = delete;
+
+	void process();
+	void stopThread();
+
+	static std::optional< Node > probeNode(std::string id);
+	static void parseCap(Node &node, const sio_cap &cap, unsigned int mode);
+
+	std::string m_name;
+	std::vector< Node > m_nodes;
+
+	// All fluxes are serviced by a single thread, polling their descriptors together.
+	// Recursive because callbacks may start or stop fluxes from the thread itself.
+	std::recursive_mutex m_fluxesLock;
+	std::vector< Flux * > m_fluxes;
+
+	std::atomic_bool m_halt;
+	// Incremented every time the thread is about to poll, lets removeFlux() wait for the current iteration.
+	std::atomic_uint64_t m_generation;
+	std::unique_ptr< std::thread > m_thread;
+
+	int m_wakeFds[2];
 };
 } // namespace sndio
 
@@ -5,14 +5,12 @@
 
 #include "Flux.hpp"
 
+#include "Engine.hpp"
 #include "Library.hpp"
 
-#include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
-#include <functional>
-#include <vector>
 
 #include <poll.h>
 
@@ -25,7 +23,9 @@ typedef CrossAudio_FluxData FluxData;
 static constexpr auto DEFAULT_NODE    = SIO_DEVANY;
 static constexpr auto DEFAULT_QUANTUM = 1024;
 
-Flux::Flux() : m_handle(nullptr), m_quantum(0) {
+Flux::Flux(Engine &engine)
+	: m_engine(engine), m_handle(nullptr), m_nfds(0), m_quantum(0), m_offset(0), m_pending(false), m_position(0),
+	  m_transferred(0), m_paused(false), m_partialTransfers(0) {
 }
 
 Flux::~Flux() {
@@ -37,21 +37,21 @@ ErrorCode Flux::start(FluxConfig &config, const FluxFeedback &feedback) {
 		return CROSSAUDIO_EC_INIT;
 	}
 
-	m_halt     = false;
+	if (config.flags & (CROSSAUDIO_FF_PLANAR | CROSSAUDIO_FF_DSP | CROSSAUDIO_FF_DRIVER | CROSSAUDIO_FF_RATE_MATCH)) {
+		return CROSSAUDIO_EC_UNSUPPORTED;
+	}
+
 	m_config   = config;
 	m_feedback = feedback;
 
 	unsigned int mode;
-	std::function< void() > threadFunc;
 
 	switch (config.direction) {
 		case CROSSAUDIO_DIR_IN:
-			mode       = SIO_REC;
-			threadFunc = [this]() { processInput(); };
+			mode = SIO_REC;
 			break;
 		case CROSSAUDIO_DIR_OUT:
-			mode       = SIO_PLAY;
-			threadFunc = [this]() { processOutput(); };
+			mode = SIO_PLAY;
 			break;
 		default:
 			return CROSSAUDIO_EC_GENERIC;
@@ -73,25 +73,44 @@ ErrorCode Flux::start(FluxConfig &config, const FluxFeedback &feedback) {
 		return CROSSAUDIO_EC_GENERIC;
 	}
 
-	m_quantum = par.appbufsz / config.channels;
+	// The device may not support the requested encoding, in which case we convert the samples ourselves.
+	if (!m_converter.setup(config, par)) {
+		stop();
+		return CROSSAUDIO_EC_NEGOTIATE;
+	}
+
+	// Transferring whole multiples of the block size avoids waking up for partial blocks.
+	m_quantum = par.round;
+	m_nfds    = lib().nfds(m_handle);
+
+	const uint32_t samples = m_quantum * m_config.channels;
+
+	m_deviceBuffer.resize(m_converter.deviceSampleSize() * samples);
+	m_clientBuffer.resize(m_converter.passthrough() ? 0 : m_converter.clientSampleSize() * samples);
+
+	m_offset           = 0;
+	m_pending          = false;
+	m_position         = 0;
+	m_transferred      = 0;
+	m_paused           = false;
+	m_partialTransfers = 0;
+	m_failed.clear();
+
+	lib().onmove(m_handle, onMove, this);
 
 	if (!lib().start(m_handle)) {
 		stop();
 		return CROSSAUDIO_EC_GENERIC;
 	}
 
-	m_thread = std::make_unique< std::thread >(threadFunc);
+	m_engine.addFlux(*this);
 
 	return CROSSAUDIO_EC_OK;
 }
 
 ErrorCode Flux::stop() {
-	m_halt = true;
-
-	if (m_thread) {
-		m_thread->join();
-		m_thread.reset();
-	}
+	// Returns once the engine's thread is done with us, our descriptors can then be closed safely.
+	m_engine.removeFlux(*this);
 
 	if (m_handle) {
 		lib().close(m_handle);
@@ -102,13 +121,40 @@ ErrorCode Flux::stop() {
 }
 
 ErrorCode Flux::pause(const bool on) {
+	if (!m_handle || m_failed.test()) {
+		return CROSSAUDIO_EC_INIT;
+	}
+
+	if (on == m_paused) {
+		return CROSSAUDIO_EC_OK;
+	}
+
+	// Done on our thread: sio_stop() drains the device's buffer, the engine's one would hold up all other fluxes.
 	if (on) {
-		m_pause.test_and_set();
+		m_engine.removeFlux(*this);
+		lib().stop(m_handle);
+
+		// A block that was only partially transferred is dropped, like what the device had buffered.
+		m_offset  = 0;
+		m_pending = false;
 	} else {
-		m_pause.clear();
+		// The device's buffer is empty after sio_stop(), its position restarts from where we left it.
+		m_transferred = m_position;
+
+		if (!lib().start(m_handle)) {
+			return CROSSAUDIO_EC_GENERIC;
+		}
+
+		m_engine.addFlux(*this);
 	}
 
-	m_pause.notify_all();
+	m_paused = on;
+
+	return CROSSAUDIO_EC_OK;
+}
+
+ErrorCode Flux::statsGet(FluxStats &stats) const {
+	stats.partialTransfers = m_partialTransfers;
 
 	return CROSSAUDIO_EC_OK;
 }
@@ -123,73 +169,113 @@ ErrorCode Flux::nameSet(const char *) {
 	return CROSSAUDIO_EC_OK;
 }
 
-void Flux::processInput() {
-	const uint32_t frameSize = (std::bit_ceil(m_config.sampleBits) / 8) * m_config.channels;
+int Flux::pollfd(PollFD *fds) {
+	return lib().pollfd(m_handle, fds, m_config.direction == CROSSAUDIO_DIR_IN ? POLLIN : POLLOUT);
+}
 
-	std::vector< std::byte > buffer(frameSize * m_quantum);
-	std::vector< pollfd > fds(lib().nfds(m_handle));
+bool Flux::process(PollFD *fds) {
+	const int events = lib().revents(m_handle, fds);
+	if (events & POLLHUP) {
+		return false;
+	}
 
-	while (!m_halt) {
-		const int numFds = lib().pollfd(m_handle, fds.data(), POLLIN);
-		if (numFds > 0 && poll(fds.data(), numFds, -1) < 0) {
-			continue;
-		}
+	if (!(events & (POLLIN | POLLOUT))) {
+		return true;
+	}
 
-		if (lib().revents(m_handle, fds.data()) & POLLHUP) {
-			return;
-		}
+	return m_config.direction == CROSSAUDIO_DIR_IN ? processInput() : processOutput();
+}
+
+bool Flux::processInput() {
+	// Under load the device may hand out less than a block, we keep what we got and wait for the rest.
+	const size_t bytes = lib().read(m_handle, m_deviceBuffer.data() + m_offset, m_deviceBuffer.size() - m_offset);
+	if (!bytes && lib().eof(m_handle)) {
+		return false;
+	}
 
-		const auto bytes = lib().read(m_handle, buffer.data(), buffer.size());
-		if (bytes != buffer.size()) {
-			return;
+	m_offset += bytes;
+	if (m_offset < m_deviceBuffer.size()) {
+		if (bytes) {
+			++m_partialTransfers;
 		}
 
-		FluxData fluxData = { buffer.data(), static_cast< uint32_t >(bytes / frameSize) };
-		m_feedback.process(m_feedback.userData, &fluxData);
+		return true;
+	}
 
-		if (m_pause.test()) {
-			lib().stop(m_handle);
-			m_pause.wait(true);
-			lib().start(m_handle);
-		}
+	m_offset = 0;
+	m_transferred += m_quantum;
+
+	auto &buffer = m_converter.passthrough() ? m_deviceBuffer : m_clientBuffer;
+
+	if (!m_converter.passthrough()) {
+		m_converter.toClient(m_clientBuffer.data(), m_deviceBuffer.data(), m_quantum * m_config.channels);
 	}
+
+	// Frames recorded by the device that we didn't read yet.
+	const auto delay  = static_cast< int64_t >(m_position - m_transferred);
+	FluxData fluxData = { buffer.data(), m_quantum, { m_position, delay, 0, 0, 0, m_quantum }, 0 };
+	m_feedback.process(m_feedback.userData, &fluxData);
+
+	return true;
 }
 
-void Flux::processOutput() {
-	const uint32_t frameSize = (std::bit_ceil(m_config.sampleBits) / 8) * m_config.channels;
+bool Flux::processOutput() {
+	// Only ask for a new block once the previous one has been entirely written.
+	if (!m_pending) {
+		auto &buffer = m_converter.passthrough() ? m_deviceBuffer : m_clientBuffer;
 
-	std::vector< std::byte > buffer(frameSize * m_quantum);
-	std::vector< pollfd > fds(lib().nfds(m_handle));
+		// Frames written that the device didn't play yet.
+		const auto delay  = static_cast< int64_t >(m_transferred - m_position);
+		FluxData fluxData = { buffer.data(), m_quantum, { m_position, delay, 0, 0, 0, m_quantum }, 0 };
+		m_feedback.process(m_feedback.userData, &fluxData);
 
-	while (!m_halt) {
-		const int numFds = lib().pollfd(m_handle, fds.data(), POLLOUT);
-		if (numFds > 0 && poll(fds.data(), numFds, -1) < 0) {
-			continue;
+		if (!m_converter.passthrough()) {
+			m_converter.toDevice(m_deviceBuffer.data(), m_clientBuffer.data(), m_quantum * m_config.channels);
 		}
 
-		if (lib().revents(m_handle, fds.data()) & POLLHUP) {
-			return;
-		}
+		m_pending = true;
+	}
 
-		FluxData fluxData = { buffer.data(), m_quantum };
-		m_feedback.process(m_feedback.userData, &fluxData);
+	const size_t bytes = lib().write(m_handle, m_deviceBuffer.data() + m_offset, m_deviceBuffer.size() - m_offset);
+	if (!bytes && lib().eof(m_handle)) {
+		return false;
+	}
 
-		const auto bytes = lib().write(m_handle, buffer.data(), buffer.size());
-		if (bytes != buffer.size()) {
-			return;
+	m_offset += bytes;
+	if (m_offset < m_deviceBuffer.size()) {
+		if (bytes) {
+			++m_partialTransfers;
 		}
 
-		if (m_pause.test()) {
-			lib().stop(m_handle);
-			m_pause.wait(true);
-			lib().start(m_handle);
-		}
+		return true;
+	}
+
+	m_offset  = 0;
+	m_pending = false;
+	m_transferred += m_quantum;
+
+	return true;
+}
+
+void Flux::fail() {
+	m_failed.test_and_set();
+
+	if (m_feedback.failed) {
+		m_feedback.failed(m_feedback.userData, CROSSAUDIO_EC_CONNECT);
 	}
 }
 
+void Flux::onMove(void *userData, const int delta) {
+	auto &flux = *static_cast< Flux * >(userData);
+
+	flux.m_position += delta;
+}
+
 bool Flux::configToPar(sio_par &par, const FluxConfig &config) {
 	lib().initpar(&par);
 
+	par.bits = config.sampleBits;
+
 	switch (config.bitFormat) {
 		default:
 		case CROSSAUDIO_BF_NONE:
@@ -201,12 +287,18 @@ bool Flux::configToPar(sio_par &par, const FluxConfig &config) {
 			par.sig = 0;
 			break;
 		case CROSSAUDIO_BF_FLOAT:
-			return false;
+			// Sndio only supports integer encodings, we ask for the highest resolution commonly available.
+			par.sig  = 1;
+			par.bits = 24;
+			break;
 	}
 
-	par.appbufsz = DEFAULT_QUANTUM * config.channels;
-	par.bits     = config.sampleBits;
+	// Double buffering: one block is transferred while the other one is being played/recorded.
+	par.round    = DEFAULT_QUANTUM;
+	par.appbufsz = DEFAULT_QUANTUM * 2;
 	par.bps      = SIO_BPS(par.bits);
+	par.le       = SIO_LE_NATIVE;
+	par.msb      = 0;
 	par.rate     = config.sampleRate;
 	par.rchan = par.pchan = config.channels;
 	par.xrun              = SIO_SYNC;
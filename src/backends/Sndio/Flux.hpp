@@ -6,26 +6,33 @@
 #ifndef CROSSAUDIO_SRC_BACKENDS_SNDIO_FLUX_HPP
 #define CROSSAUDIO_SRC_BACKENDS_SNDIO_FLUX_HPP
 
+#include "Converter.hpp"
+
 #include "crossaudio/ErrorCode.h"
 #include "crossaudio/Flux.h"
 
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
-#include <memory>
-#include <thread>
+#include <vector>
 
 typedef CrossAudio_ErrorCode ErrorCode;
 
 typedef CrossAudio_FluxConfig FluxConfig;
 typedef CrossAudio_FluxFeedback FluxFeedback;
+typedef CrossAudio_FluxStats FluxStats;
+
+typedef struct pollfd PollFD;
 
 struct sio_hdl;
 struct sio_par;
 
 namespace sndio {
+class Engine;
+
 class Flux {
 public:
-	Flux();
+	Flux(Engine &engine);
 	~Flux();
 
 	const char *nameGet() const;
@@ -35,24 +42,51 @@ public:
 	ErrorCode stop();
 	ErrorCode pause(bool on);
 
+	ErrorCode statsGet(FluxStats &stats) const;
+
+	// The functions below are called by the engine's thread.
+
+	int pollfd(PollFD *fds);
+	bool process(PollFD *fds);
+	void fail();
+
+	constexpr int nfds() const { return m_nfds; }
+
 private:
 	Flux(const Flux &)            = delete;
 	Flux &operator=(const Flux &) = delete;
 
-	void processInput();
-	void processOutput();
+	bool processInput();
+	bool processOutput();
+
+	static void onMove(void *userData, int delta);
 
 	static bool configToPar(sio_par &par, const FluxConfig &config);
 
+	Engine &m_engine;
+
 	FluxConfig m_config;
 	FluxFeedback m_feedback;
 
-	sio_hdl *m_handle;
-	uint16_t m_quantum;
+	Converter m_converter;
 
-	std::atomic_bool m_halt;
-	std::atomic_flag m_pause;
-	std::unique_ptr< std::thread > m_thread;
+	sio_hdl *m_handle;
+	int m_nfds;
+	uint32_t m_quantum;
+
+	// Only accessed by the engine's thread while the flux is registered, sio_onmove() callbacks are issued
+	// from within the library calls it makes.
+	std::vector< std::byte > m_deviceBuffer;
+	std::vector< std::byte > m_clientBuffer;
+	size_t m_offset;
+	// Whether the device buffer holds a rendered block that wasn't entirely written yet.
+	bool m_pending;
+	uint64_t m_position;
+	uint64_t m_transferred;
+	bool m_paused;
+
+	std::atomic_uint64_t m_partialTransfers;
+	std::atomic_flag m_failed;
 };
 } // namespace sndio
 
@@ -40,10 +40,13 @@ ErrorCode Library::load(const std::string_view libraryName) {
 	LOAD_SYM(initpar)
 	LOAD_SYM(getpar)
 	LOAD_SYM(setpar)
+	LOAD_SYM(getcap)
+	LOAD_SYM(onmove)
 
 	LOAD_SYM(nfds)
 	LOAD_SYM(pollfd)
 	LOAD_SYM(revents)
+	LOAD_SYM(eof)
 
 	return CROSSAUDIO_EC_OK;
 }
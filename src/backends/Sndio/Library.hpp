@@ -15,6 +15,7 @@ using ErrorCode = CrossAudio_ErrorCode;
 
 typedef struct pollfd PollFD;
 
+struct sio_cap;
 struct sio_hdl;
 struct sio_par;
 
@@ -43,10 +44,13 @@ public:
 	void (*initpar)(sio_par *par);
 	int (*getpar)(sio_hdl *hdl, sio_par *par);
 	int (*setpar)(sio_hdl *hdl, sio_par *par);
+	int (*getcap)(sio_hdl *hdl, sio_cap *cap);
+	void (*onmove)(sio_hdl *hdl, void (*cb)(void *arg, int delta), void *arg);
 
 	int (*nfds)(sio_hdl *hdl);
 	int (*pollfd)(sio_hdl *hdl, PollFD *pfd, int events);
 	int (*revents)(sio_hdl *hdl, PollFD *pfd);
+	int (*eof)(sio_hdl *hdl);
 
 private:
 	Library();
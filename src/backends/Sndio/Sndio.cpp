@@ -59,7 +59,15 @@ static ErrorCode deinit() {
 }
 
 static BE_Engine *engineNew() {
-	return reinterpret_cast< BE_Engine * >(new Engine());
+	if (auto engine = new Engine()) {
+		if (*engine) {
+			return reinterpret_cast< BE_Engine * >(engine);
+		}
+
+		delete engine;
+	}
+
+	return nullptr;
 }
 
 static ErrorCode engineFree(BE_Engine *engine) {
@@ -68,28 +76,28 @@ static ErrorCode engineFree(BE_Engine *engine) {
 	return CROSSAUDIO_EC_OK;
 }
 
-static ErrorCode engineStart(BE_Engine *, const EngineFeedback *) {
-	return CROSSAUDIO_EC_OK;
+static ErrorCode engineStart(BE_Engine *engine, const EngineFeedback *) {
+	return toImpl(engine)->start();
 }
 
-static ErrorCode engineStop(BE_Engine *) {
-	return CROSSAUDIO_EC_OK;
+static ErrorCode engineStop(BE_Engine *engine) {
+	return toImpl(engine)->stop();
 }
 
-static const char *engineNameGet(BE_Engine *) {
-	return nullptr;
+static const char *engineNameGet(BE_Engine *engine) {
+	return toImpl(engine)->nameGet();
 }
 
-static ErrorCode engineNameSet(BE_Engine *, const char *) {
-	return CROSSAUDIO_EC_OK;
+static ErrorCode engineNameSet(BE_Engine *engine, const char *name) {
+	return toImpl(engine)->nameSet(name);
 }
 
-static Nodes *engineNodesGet(BE_Engine *) {
-	return nullptr;
+static Nodes *engineNodesGet(BE_Engine *engine) {
+	return toImpl(engine)->engineNodesGet();
 }
 
-static BE_Flux *fluxNew(BE_Engine *) {
-	return reinterpret_cast< BE_Flux * >(new Flux());
+static BE_Flux *fluxNew(BE_Engine *engine) {
+	return reinterpret_cast< BE_Flux * >(new Flux(*toImpl(engine)));
 }
 
 static ErrorCode fluxFree(BE_Flux *flux) {
@@ -118,6 +126,10 @@ static ErrorCode fluxNameSet(BE_Flux *flux, const char *name) {
 	return toImpl(flux)->nameSet(name);
 }
 
+static ErrorCode fluxStatsGet(BE_Flux *flux, FluxStats *stats) {
+	return toImpl(flux)->statsGet(*stats);
+}
+
 // clang-format off
 constexpr BE_Impl Sndio_Impl = {
 	name,
@@ -140,6 +152,14 @@ constexpr BE_Impl Sndio_Impl = {
 	fluxStop,
 	fluxPause,
 	fluxNameGet,
-	fluxNameSet
+	fluxNameSet,
+
+	fluxStatsGet,
+	nullptr,
+	nullptr,
+	nullptr,
+	nullptr,
+	nullptr,
+	nullptr
 };
 // clang-format on
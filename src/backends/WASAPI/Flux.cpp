@@ -47,6 +47,10 @@ ErrorCode Flux::start(FluxConfig &config, const FluxFeedback &feedback) {
 		return CROSSAUDIO_EC_INIT;
 	}
 
+	if (config.flags & (CROSSAUDIO_FF_PLANAR | CROSSAUDIO_FF_DSP | CROSSAUDIO_FF_DRIVER | CROSSAUDIO_FF_RATE_MATCH)) {
+		return CROSSAUDIO_EC_UNSUPPORTED;
+	}
+
 	m_halt     = false;
 	m_feedback = feedback;
 
@@ -211,7 +215,7 @@ void Flux::processInput() {
 				goto cleanup;
 			}
 
-			FluxData fluxData = { flags & AUDCLNT_BUFFERFLAGS_SILENT ? nullptr : buffer, frames };
+			FluxData fluxData = { flags & AUDCLNT_BUFFERFLAGS_SILENT ? nullptr : buffer, frames, {}, 0 };
 			m_feedback.process(m_feedback.userData, &fluxData);
 
 			if (client->ReleaseBuffer(frames) != S_OK) {
@@ -280,7 +284,7 @@ void Flux::processOutput() {
 				goto cleanup;
 			}
 
-			FluxData fluxData = { buffer, frames };
+			FluxData fluxData = { buffer, frames, {}, 0 };
 			m_feedback.process(m_feedback.userData, &fluxData);
 
 			DWORD flags = 0;
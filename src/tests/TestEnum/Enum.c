@@ -25,12 +25,28 @@ static void nodeRemoved(void *userData, Node *node) {
 	CrossAudio_nodeFree(node);
 }
 
+static void nodeUpdated(void *userData, Node *node) {
+	(void)userData;
+	printf("Node updated: [%s] %s (%s)\n", node->id, node->name, CrossAudio_DirectionText(node->direction));
+	CrossAudio_nodeFree(node);
+}
+
+static void defaultNodeChanged(void *userData, Node *node) {
+	(void)userData;
+	printf("Default node changed: [%s] %s (%s)\n", node->id, node->name, CrossAudio_DirectionText(node->direction));
+	CrossAudio_nodeFree(node);
+}
+
 int main() {
 	if (!initBackend()) {
 		return 1;
 	}
 
-	const EngineFeedback feedback = { .userData = NULL, .nodeAdded = nodeAdded, .nodeRemoved = nodeRemoved };
+	const EngineFeedback feedback = { .userData           = NULL,
+									  .nodeAdded          = nodeAdded,
+									  .nodeRemoved        = nodeRemoved,
+									  .nodeUpdated        = nodeUpdated,
+									  .defaultNodeChanged = defaultNodeChanged };
 
 	Engine *engine = createEngine(&feedback);
 	if (!engine) {
@@ -56,6 +72,14 @@ int main() {
 		}
 
 		CrossAudio_nodesFree(nodes);
+
+		for (enum CrossAudio_Direction direction = CROSSAUDIO_DIR_IN; direction <= CROSSAUDIO_DIR_OUT; ++direction) {
+			Node *node = CrossAudio_engineDefaultNodeGet(engine, direction);
+			if (node) {
+				printf("Default: [%s] %s (%s)\n", node->id, node->name, CrossAudio_DirectionText(direction));
+				CrossAudio_nodeFree(node);
+			}
+		}
 	} while (getchar() != 'q');
 
 	if (!destroyEngine(engine)) {
@@ -26,6 +26,11 @@ typedef struct CrossAudio_FluxData FluxData;
 static void inProcess(void *userData, FluxData *data) {
 	RingBuffer *buffer = userData;
 
+	// Silence, the output flux plays it anyway when the ring buffer runs dry.
+	if (!data->data) {
+		return;
+	}
+
 	ringBufferWrite(buffer, data->data, FRAME_SIZE * data->frames);
 }
 